@@ -0,0 +1,61 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 21st, 2026
+ *
+ * This file implements the Arena class defined in arena.hpp
+ */
+
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+Arena::Arena(Arena &&other) noexcept
+    : blocks(std::move(other.blocks)), cursor(other.cursor), limit(other.limit), reserved_bytes(other.reserved_bytes) {
+    other.blocks.clear();
+    other.cursor = other.limit = nullptr;
+    other.reserved_bytes = 0;
+}
+
+Arena &Arena::operator=(Arena &&other) noexcept {
+    if (this != &other) {
+        for (auto block : blocks)
+            delete[] block;
+        blocks = std::move(other.blocks);
+        cursor = other.cursor;
+        limit = other.limit;
+        reserved_bytes = other.reserved_bytes;
+        other.blocks.clear();
+        other.cursor = other.limit = nullptr;
+        other.reserved_bytes = 0;
+    }
+    return *this;
+}
+
+Arena::~Arena() {
+    for (auto block : blocks)
+        delete[] block;
+}
+
+// The current block is full: start a new one, at least twice as large as the previous one
+void* Arena::allocate_slow(size_t size, size_t align) {
+    size_t block_size = blocks.empty() ? FIRST_BLOCK_SIZE : (size_t)(limit - blocks.back()) * 2;
+    block_size = std::max(block_size, size + align);
+    char* block = new char[block_size];
+    blocks.push_back(block);
+    reserved_bytes += block_size;
+    cursor = block;
+    limit = block + block_size;
+    return allocate(size, align);
+}
+
+std::string_view Arena::copy(std::string_view text, size_t extra_zeros) {
+    char* data = (char*)allocate(text.size() + extra_zeros, 1);
+    std::memcpy(data, text.data(), text.size());
+    std::memset(data + text.size(), 0, extra_zeros);
+    return std::string_view(data, text.size());
+}
@@ -0,0 +1,84 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 21st, 2026
+ *
+ * This file defines the Arena class, the per-compilation storage of the parse tree and the source text.
+ */
+
+#ifndef CSC4180_ARENA_HPP
+#define CSC4180_ARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Bump allocator
+ *
+ * Memory is handed out from large blocks by moving a pointer forward. Nothing is freed one by one:
+ * everything allocated from an arena is released at once when the arena is destroyed, so only
+ * trivially destructible objects (Node, lexemes, children arrays) may live in it.
+ * Blocks double in size, a compilation therefore needs only a handful of them.
+ */
+class Arena {
+public:
+    static const size_t FIRST_BLOCK_SIZE = 16 * 1024;
+
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    Arena(Arena &&other) noexcept;
+    Arena &operator=(Arena &&other) noexcept;
+    ~Arena();
+
+    /**
+     * @param size: bytes to allocate
+     * @param align: alignment, a power of two
+     * @return uninitialized memory valid until the arena is destroyed
+     */
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t padding = (align - (size_t)cursor % align) % align;
+        if (cursor == nullptr || size + padding > (size_t)(limit - cursor)) return allocate_slow(size, align);
+        char* result = cursor + padding;
+        cursor = result + size;
+        return result;
+    }
+
+    /**
+     * Construct an object in the arena, its destructor is never called
+     */
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Copy a string into the arena
+     * @param text
+     * @param extra_zeros: NUL bytes appended after the copy, not part of the returned view
+     * @return view of the copy
+     */
+    std::string_view copy(std::string_view text, size_t extra_zeros = 0);
+
+    /**
+     * @return total number of bytes reserved from the system
+     */
+    size_t capacity() const { return reserved_bytes; }
+
+private:
+    void* allocate_slow(size_t size, size_t align);
+
+private:
+    std::vector<char*> blocks;
+    char* cursor = nullptr;     // next free byte in the last block
+    char* limit = nullptr;      // end of the last block
+    size_t reserved_bytes = 0;
+};
+
+#endif  // CSC4180_ARENA_HPP
@@ -0,0 +1,92 @@
+# CUHK-SZ CSC4180: Compiler Construction
+# Assignment 1: Micro Language Compiler
+# Author: HaoLUO
+# Date: October 24th, 2026
+#
+# Scaling benchmark of the Micro compiler: generates programs of growing size with gen_micro.py, compiles
+# each with --stats-json, and reports the time and memory of every phase against the input size.
+#
+# Usage: python3 bench.py [--param statements] [--sizes 100,1000,10000] [--output bench]
+#   writes <output>.csv, and <output>.png when matplotlib is installed
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+def measure(compiler, program):
+    """
+    @return {phase name: phase statistics} of one compilation
+    """
+    command = [compiler, "--stats-json", "-d", os.devnull, "-o", os.devnull, "-S", os.devnull, program]
+    result = subprocess.run(command, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, check=True)
+    report = json.loads(result.stderr)["programs"][0]
+    return report, {phase["name"]: phase for phase in report["phases"]}
+
+def plot(rows, param, phases, output):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print("matplotlib is not installed, no plot")
+        return
+    figure, (time_axis, memory_axis) = plt.subplots(1, 2, figsize=(12, 5))
+    for phase in phases:
+        points = [(row["size"], row[phase + "_ms"], row[phase + "_alloc_bytes"]) for row in rows]
+        time_axis.plot([p[0] for p in points], [p[1] for p in points], marker="o", label=phase)
+        memory_axis.plot([p[0] for p in points], [p[2] for p in points], marker="o", label=phase)
+    memory_axis.plot([row["size"] for row in rows], [row["peak_rss_kb"] * 1024 for row in rows],
+                     linestyle="--", color="black", label="peak RSS")
+    for axis, title in ((time_axis, "wall time (ms)"), (memory_axis, "allocated bytes")):
+        axis.set_xscale("log")
+        axis.set_yscale("log")
+        axis.set_xlabel(param)
+        axis.set_title(title)
+        axis.legend()
+    figure.tight_layout()
+    figure.savefig(output + ".png")
+    print("plot written to " + output + ".png")
+
+def main():
+    parser = argparse.ArgumentParser(description="Sweep program sizes and measure every phase of the compiler")
+    parser.add_argument("--compiler", default=os.path.join(HERE, "compiler"))
+    parser.add_argument("--param", default="statements", choices=["statements", "depth", "variables", "list-length"],
+                        help="the generator option to sweep, the others keep their defaults")
+    parser.add_argument("--sizes", default="100,300,1000,3000,10000", help="values of the swept option")
+    parser.add_argument("--output", default="bench", help="prefix of the .csv and .png files")
+    args = parser.parse_args()
+    sizes = [int(size) for size in args.sizes.split(",")]
+    rows = []
+    phases = []
+    with tempfile.TemporaryDirectory() as directory:
+        for size in sizes:
+            program = os.path.join(directory, "bench%d.m" % size)
+            subprocess.run([sys.executable, os.path.join(HERE, "gen_micro.py"), "--" + args.param, str(size),
+                            program], check=True)
+            report, stats = measure(args.compiler, program)
+            phases = [name for name in stats]
+            row = {"size": size, "bytes": os.path.getsize(program), "tokens": report["tokens"],
+                   "nodes": report["nodes"], "peak_rss_kb": max(p["peak_rss_kb"] for p in stats.values())}
+            for name, phase in stats.items():
+                row[name + "_ms"] = phase["wall_ms"]
+                row[name + "_alloc_bytes"] = phase["allocated_bytes"]
+            rows.append(row)
+            print("%s=%-8d %10d bytes  " % (args.param, size, row["bytes"])
+                  + "  ".join("%s %.1f ms" % (name, row[name + "_ms"]) for name in phases)
+                  + "  peak %d KiB" % row["peak_rss_kb"])
+    columns = ["size", "bytes", "tokens", "nodes", "peak_rss_kb"]
+    columns += [name + suffix for name in phases for suffix in ("_ms", "_alloc_bytes")]
+    with open(args.output + ".csv", "w") as file:
+        file.write(",".join(columns) + "\n")
+        for row in rows:
+            file.write(",".join(str(row.get(column, "")) for column in columns) + "\n")
+    print("table written to " + args.output + ".csv")
+    plot(rows, args.param, phases, args.output)
+
+if __name__ == "__main__":
+    main()
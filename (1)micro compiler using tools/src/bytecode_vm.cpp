@@ -0,0 +1,261 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 20th, 2026
+ *
+ * This file implements the Bytecode VM class defined in bytecode_vm.hpp
+ */
+
+#include "bytecode_vm.hpp"
+
+void Bytecode_VM::compile(Node* node) {
+    compile(FlatAst(node));
+}
+
+void Bytecode_VM::compile(const FlatAst& ast) {
+    if (ast.empty()) {
+        std::cerr << "Error: the ast is empty!" << std::endl;
+        return;
+    }
+    this->ast = &ast;
+    code.clear();
+    variables.clear();
+    max_depth = 0;
+    collect_variables(ast.root());
+    gen_statement(ast.root());
+    emit(Opcode::HALT, 0);
+}
+
+void Bytecode_VM::collect_variables(NodeRef node) {
+    // forward scan in pre-order, which numbers variables in source order
+    for (uint32_t index = node.index(); index < node.subtree_end(); ++index) {
+        if (ast->symbol_class[index] == SymbolClass::ID) {
+            std::string_view name = ast->lexeme(index);
+            if (variables.find(name) == variables.end()) {
+                uint32_t reg = variables.size();
+                variables[name] = reg;
+            }
+        }
+    }
+}
+
+void Bytecode_VM::gen_statement(NodeRef node) {
+    // forward scan in pre-order, the subtree of a statement is skipped once lowered
+    uint32_t index = node.index();
+    while (index < node.subtree_end()) {
+        NodeRef current = ast->node(index);
+        switch (current.symbol_class()) {
+            case SymbolClass::ASSIGNOP: {
+                uint32_t variable = variables[current.child(0).lexeme()];
+                uint32_t value = gen_expression(current.child(1), 0);
+                // write the last result straight into the variable instead of moving it
+                if (value >= variables.size() && !code.empty() && code.back().a == value) {
+                    code.back().a = variable;
+                } else if (value != variable) {
+                    emit(Opcode::MOV, variable, value);
+                }
+                break;
+            }
+            case SymbolClass::READ:
+                for (NodeRef child : current.children()) {
+                    emit(Opcode::READ, variables[child.lexeme()]);
+                }
+                break;
+            case SymbolClass::WRITE:
+                for (NodeRef child : current.children()) {
+                    uint32_t value = gen_expression(child, 0);
+                    // the last expression of the list ends the line
+                    emit(ast->next_sibling[child.index()] == FlatAst::NONE ? Opcode::WRITELN : Opcode::WRITE, value);
+                }
+                break;
+            default:
+                ++index;
+                continue;
+        }
+        index = current.subtree_end();
+    }
+}
+
+uint32_t Bytecode_VM::gen_expression(NodeRef node, uint32_t depth) {
+    // Post-order walk with an explicit stack of the operators being lowered, so that arbitrarily deep
+    // expressions use no call stack; `result` is the register of the operand finished last
+    enum Stage { START, LEFT_DONE, RIGHT_DONE };
+    struct Frame {
+        NodeRef node;
+        uint32_t depth;
+        Stage stage;
+        uint32_t lvalue;
+    };
+    std::vector<Frame> stack{{node, depth, START, 0}};
+    uint32_t result = 0;
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        NodeRef current = frame.node;
+        uint32_t target = variables.size() + frame.depth;
+        bool is_add = current.symbol_class() == SymbolClass::PLUSOP;
+        switch (frame.stage) {
+            case START:
+                if (frame.depth + 1 > max_depth) max_depth = frame.depth + 1;
+                switch (current.symbol_class()) {
+                    case SymbolClass::ID:
+                        result = variables[current.lexeme()];
+                        stack.pop_back();
+                        break;
+                    case SymbolClass::INTLITERAL:
+                        emit_imm(Opcode::LOADI, target, 0, current.int_value());
+                        result = target;
+                        stack.pop_back();
+                        break;
+                    case SymbolClass::PLUSOP:
+                    case SymbolClass::MINUSOP: {
+                        frame.stage = LEFT_DONE;
+                        uint32_t left_depth = frame.depth;
+                        stack.push_back({current.child(0), left_depth, START, 0});
+                        break;
+                    }
+                    default:
+                        std::cerr << "Error oprand!" << std::endl;
+                        result = target;
+                        stack.pop_back();
+                        break;
+                }
+                break;
+            case LEFT_DONE: {
+                frame.lvalue = result;
+                NodeRef right_child = current.child(1);
+                if (right_child.symbol_class() == SymbolClass::INTLITERAL) {
+                    // wrap-around negation, same as the 32-bit subtraction it replaces
+                    uint32_t imm = (uint32_t)right_child.int_value();
+                    emit_imm(Opcode::ADDI, target, frame.lvalue, (int32_t)(is_add ? imm : 0u - imm));
+                    result = target;
+                    stack.pop_back();
+                    break;
+                }
+                frame.stage = RIGHT_DONE;
+                uint32_t right_depth = frame.depth + 1;
+                stack.push_back({right_child, right_depth, START, 0});
+                break;
+            }
+            case RIGHT_DONE:
+                emit(is_add ? Opcode::ADD : Opcode::SUB, target, frame.lvalue, result);
+                result = target;
+                stack.pop_back();
+                break;
+        }
+    }
+    return result;
+}
+
+void Bytecode_VM::emit(Opcode opcode, uint32_t a, uint32_t b, uint32_t c) {
+    Instruction inst;
+    inst.opcode = opcode;
+    inst.a = a;
+    inst.b = b;
+    inst.c = c;
+    code.push_back(inst);
+}
+
+void Bytecode_VM::emit_imm(Opcode opcode, uint32_t a, uint32_t b, int32_t imm) {
+    Instruction inst;
+    inst.opcode = opcode;
+    inst.a = a;
+    inst.b = b;
+    inst.imm = imm;
+    code.push_back(inst);
+}
+
+/**
+ * Read the next integer in the same way as scanf("%d"): skip whitespace, optional sign, digits
+ * @return false if no integer is left, the register is then left unchanged like scanf does
+ */
+static bool read_int(FILE* input, int32_t &value) {
+    int c = getc_unlocked(input);
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f')
+        c = getc_unlocked(input);
+    bool negative = false;
+    if (c == '-' || c == '+') {
+        negative = c == '-';
+        c = getc_unlocked(input);
+    }
+    if (c < '0' || c > '9') {
+        if (c != EOF) ungetc(c, input);
+        return false;
+    }
+    uint32_t result = 0;
+    while (c >= '0' && c <= '9') {
+        result = result * 10 + (uint32_t)(c - '0');
+        c = getc_unlocked(input);
+    }
+    if (c != EOF) ungetc(c, input);
+    value = (int32_t)(negative ? 0u - result : result);
+    return true;
+}
+
+/*
+ * Micro integers are i32 in the IR, so arithmetic is done on uint32_t to wrap around without undefined behavior.
+ * With GCC/Clang every handler jumps straight to the next one through a label table (threaded dispatch),
+ * otherwise a plain switch loop is used.
+ */
+void Bytecode_VM::run(FILE* input, OutputBuffer &output) {
+    std::vector<int32_t> registers(variables.size() + max_depth, 0);
+    int32_t* r = registers.data();
+    const Instruction* pc = code.data();
+    if (pc == nullptr) return;
+
+#if defined(__GNUC__)
+    static const void* dispatch_table[] = {
+        &&op_loadi, &&op_mov, &&op_add, &&op_sub, &&op_addi, &&op_read, &&op_write, &&op_writeln, &&op_halt,
+    };
+#define DISPATCH() goto *dispatch_table[(int)pc->opcode]
+#define NEXT() do { ++pc; DISPATCH(); } while (0)
+    DISPATCH();
+op_loadi:
+    r[pc->a] = pc->imm;
+    NEXT();
+op_mov:
+    r[pc->a] = r[pc->b];
+    NEXT();
+op_add:
+    r[pc->a] = (int32_t)((uint32_t)r[pc->b] + (uint32_t)r[pc->c]);
+    NEXT();
+op_sub:
+    r[pc->a] = (int32_t)((uint32_t)r[pc->b] - (uint32_t)r[pc->c]);
+    NEXT();
+op_addi:
+    r[pc->a] = (int32_t)((uint32_t)r[pc->b] + (uint32_t)pc->imm);
+    NEXT();
+op_read:
+    read_int(input, r[pc->a]);
+    NEXT();
+op_write:
+    output << r[pc->a] << ' ';
+    NEXT();
+op_writeln:
+    output << r[pc->a] << '\n';
+    NEXT();
+op_halt:
+    output.flush();
+    return;
+#undef NEXT
+#undef DISPATCH
+#else
+    for (;; ++pc) {
+        switch (pc->opcode) {
+            case Opcode::LOADI:     r[pc->a] = pc->imm; break;
+            case Opcode::MOV:       r[pc->a] = r[pc->b]; break;
+            case Opcode::ADD:       r[pc->a] = (int32_t)((uint32_t)r[pc->b] + (uint32_t)r[pc->c]); break;
+            case Opcode::SUB:       r[pc->a] = (int32_t)((uint32_t)r[pc->b] - (uint32_t)r[pc->c]); break;
+            case Opcode::ADDI:      r[pc->a] = (int32_t)((uint32_t)r[pc->b] + (uint32_t)pc->imm); break;
+            case Opcode::READ:      read_int(input, r[pc->a]); break;
+            case Opcode::WRITE:     output << r[pc->a] << ' '; break;
+            case Opcode::WRITELN:   output << r[pc->a] << '\n'; break;
+            case Opcode::HALT:
+                output.flush();
+                return;
+        }
+    }
+#endif
+}
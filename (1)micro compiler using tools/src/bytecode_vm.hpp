@@ -0,0 +1,109 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 20th, 2026
+ *
+ * This file defines the Bytecode VM class, which lowers the AST to a compact register bytecode
+ * and interprets it in-process, without LLVM, a cross compiler or qemu.
+ */
+
+#ifndef CSC4180_BYTECODE_VM_HPP
+#define CSC4180_BYTECODE_VM_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flat_ast.hpp"
+#include "node.hpp"
+#include "output_buffer.hpp"
+
+/**
+ * Opcodes of the register bytecode
+ * Registers [0, #variables) hold Micro variables, the following ones hold expression temporaries
+ */
+enum class Opcode : uint8_t {
+    LOADI,      // r[a] = imm
+    MOV,        // r[a] = r[b]
+    ADD,        // r[a] = r[b] + r[c]
+    SUB,        // r[a] = r[b] - r[c]
+    ADDI,       // r[a] = r[b] + imm
+    READ,       // r[a] = next integer from input
+    WRITE,      // print r[a], followed by a space
+    WRITELN,    // print r[a], followed by a newline
+    HALT,
+};
+
+struct Instruction {
+    Opcode opcode;
+    uint32_t a;
+    uint32_t b;
+    union {
+        uint32_t c;
+        int32_t imm;
+    };
+};
+
+/**
+ * Bytecode VM of Micro Language
+ * compile() lowers the AST once, run() can then execute it any number of times.
+ */
+class Bytecode_VM {
+public:
+    Bytecode_VM() = default;
+
+    /**
+     * Lower the AST into bytecode
+     * @param ast: the flattened AST
+     * @return
+     */
+    void compile(const FlatAst& ast);
+
+    /**
+     * Same as above for a Node tree, which is flattened first
+     * @param node: root of the AST
+     * @return
+     */
+    void compile(Node* node);
+
+    /**
+     * Execute the bytecode with threaded dispatch
+     * @param input: stream the read statements take integers from
+     * @param output: stream the write statements print to
+     * @return
+     */
+    void run(FILE* input, OutputBuffer &output);
+
+private:
+    /**
+     * Give every Micro variable a register, in order of first appearance
+     */
+    void collect_variables(NodeRef node);
+
+    void gen_statement(NodeRef node);
+
+    /**
+     * Lower an expression into registers starting at temporary `depth`
+     * The expression tree is walked with an explicit stack, its depth is not bounded by the call stack
+     * @return the register holding the result
+     */
+    uint32_t gen_expression(NodeRef node, uint32_t depth);
+
+    void emit(Opcode opcode, uint32_t a, uint32_t b = 0, uint32_t c = 0);
+
+    void emit_imm(Opcode opcode, uint32_t a, uint32_t b, int32_t imm);
+
+private:
+    const FlatAst* ast = nullptr;                   // the tree being lowered
+    std::vector<Instruction> code;
+    std::map<std::string_view, uint32_t> variables; // variable name -> register
+    uint32_t max_depth = 0;                         // number of temporaries needed
+};
+
+#endif  // CSC4180_BYTECODE_VM_HPP
@@ -0,0 +1,231 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 23rd, 2026
+ *
+ * This file implements the CompileCache class defined in compile_cache.hpp
+ */
+
+#include "compile_cache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char MAGIC[8] = {'C', 'S', 'C', '4', '1', '8', '0', 'C'};
+static const char SUFFIX[] = ".cache";
+
+/*
+ * Entry file: magic, u64 key size, key, u32 entry count, then per entry u32 name size, name, u64 size, content
+ * (host byte order, the cache is local)
+ */
+template <typename T>
+static void append_int(std::string &data, T value) {
+    data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool read_int(const std::string &data, size_t &offset, T &value) {
+    if (data.size() - offset < sizeof(value)) return false;
+    memcpy(&value, data.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+static bool read_bytes(const std::string &data, size_t &offset, uint64_t size, std::string &bytes) {
+    if (data.size() - offset < size) return false;
+    bytes.assign(data, offset, size);
+    offset += size;
+    return true;
+}
+
+static bool read_file(const std::string &path, std::string &data) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    data.resize(st.st_size);
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = read(fd, &data[done], data.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    close(fd);
+    return done == data.size();
+}
+
+static bool write_file(const std::string &path, const std::string &data) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    return close(fd) == 0 && done == data.size();
+}
+
+// 64-bit FNV-1a
+static uint64_t fnv1a(const std::string &bytes) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * Every build of the compiler has its own entries: they are keyed on a hash of the running binary, read once
+ * per process. If the binary cannot be read, the id is unique to the process, so its entries are never hit.
+ * @return the id, in hex
+ */
+static const std::string &build_id() {
+    static const std::string id = [] {
+        std::string binary;
+        char text[64];
+        if (read_file("/proc/self/exe", binary))
+            snprintf(text, sizeof(text), "%016llx", (unsigned long long)fnv1a(binary));
+        else
+            snprintf(text, sizeof(text), "process %ld %lld", (long)getpid(), (long long)time(nullptr));
+        return std::string(text);
+    }();
+    return id;
+}
+
+// mkdir -p
+static void make_directories(const std::string &path) {
+    for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        mkdir(path.substr(0, slash).c_str(), 0755);
+        if (slash == std::string::npos) break;
+    }
+}
+
+CompileCache::CompileCache(const std::string &directory, uint64_t max_bytes)
+    : directory(directory), max_bytes(max_bytes) {
+    make_directories(directory);
+}
+
+std::string CompileCache::key(std::string_view source, const std::string &flags) const {
+    std::string key = build_id();
+    key += '\0';
+    key += flags;
+    key += '\0';
+    key.append(source.data(), source.size());
+    return key;
+}
+
+// 64-bit FNV-1a of the key, in hex
+std::string CompileCache::path_of(const std::string &key) const {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)fnv1a(key));
+    return directory + "/" + name + SUFFIX;
+}
+
+bool CompileCache::lookup(std::string_view source, const std::string &flags, std::vector<Entry> &entries) {
+    std::string expected_key = key(source, flags);
+    std::string path = path_of(expected_key);
+    std::string data;
+    size_t offset = sizeof(MAGIC);
+    uint64_t key_size;
+    std::string stored_key;
+    uint32_t count;
+    bool hit = read_file(path, data) && data.size() >= sizeof(MAGIC) && memcmp(data.data(), MAGIC, sizeof(MAGIC)) == 0
+        && read_int(data, offset, key_size) && read_bytes(data, offset, key_size, stored_key)
+        && stored_key == expected_key && read_int(data, offset, count);
+    entries.clear();
+    for (uint32_t i = 0; hit && i < count; ++i) {
+        uint32_t name_size;
+        uint64_t content_size;
+        Entry entry;
+        hit = read_int(data, offset, name_size) && read_bytes(data, offset, name_size, entry.name)
+            && read_int(data, offset, content_size) && read_bytes(data, offset, content_size, entry.content);
+        entries.push_back(std::move(entry));
+    }
+    if (!hit) {
+        entries.clear();
+        ++miss_count;
+        return false;
+    }
+    // the modification time is the last use, for LRU eviction
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    ++hit_count;
+    return true;
+}
+
+void CompileCache::store(std::string_view source, const std::string &flags, const std::vector<Entry> &entries) {
+    std::string entry_key = key(source, flags);
+    std::string data(MAGIC, sizeof(MAGIC));
+    append_int<uint64_t>(data, entry_key.size());
+    data += entry_key;
+    append_int<uint32_t>(data, entries.size());
+    for (auto &entry : entries) {
+        append_int<uint32_t>(data, entry.name.size());
+        data += entry.name;
+        append_int<uint64_t>(data, entry.content.size());
+        data += entry.content;
+    }
+    // unique among processes and threads, renamed over the entry only once complete
+    std::string path = path_of(entry_key);
+    std::string temp_path = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(temp_counter++);
+    if (!write_file(temp_path, data) || rename(temp_path.c_str(), path.c_str()) != 0) {
+        unlink(temp_path.c_str());
+        return;
+    }
+    evict();
+}
+
+void CompileCache::evict() {
+    struct File {
+        std::string path;
+        uint64_t size;
+        struct timespec used;
+    };
+    std::vector<File> files;
+    uint64_t total = 0;
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) return;
+    size_t suffix_length = sizeof(SUFFIX) - 1;
+    while (struct dirent* item = readdir(dir)) {
+        std::string name = item->d_name;
+        if (name.size() <= suffix_length || name.compare(name.size() - suffix_length, suffix_length, SUFFIX) != 0) {
+            continue;
+        }
+        File file;
+        file.path = directory + "/" + name;
+        struct stat st;
+        if (stat(file.path.c_str(), &st) != 0) continue;
+        file.size = st.st_size;
+        file.used = st.st_mtim;
+        total += file.size;
+        files.push_back(std::move(file));
+    }
+    closedir(dir);
+    if (total <= max_bytes) return;
+    std::sort(files.begin(), files.end(), [](const File &a, const File &b) {
+        return a.used.tv_sec != b.used.tv_sec ? a.used.tv_sec < b.used.tv_sec : a.used.tv_nsec < b.used.tv_nsec;
+    });
+    for (auto &file : files) {
+        if (total <= max_bytes) break;
+        // another process may have removed it already
+        unlink(file.path.c_str());
+        total -= file.size;
+    }
+}
@@ -0,0 +1,81 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 23rd, 2026
+ *
+ * This file defines the CompileCache class, an on-disk cache of compiler outputs keyed by the source content.
+ */
+
+#ifndef CSC4180_COMPILE_CACHE_HPP
+#define CSC4180_COMPILE_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Content-addressed compilation cache
+ *
+ * An entry holds every output of one compilation, under a hash of the compiler binary, the flags that change
+ * the outputs and the source bytes. The key itself is stored in the entry and compared on lookup, so a hash
+ * collision is a miss, never a wrong output.
+ *   - entries are written to a temporary file and renamed into place, so a reader never sees half an entry
+ *   - a hit touches the entry, and when the directory grows over max_bytes the least recently used entries
+ *     are removed
+ * Several compiler processes (or threads) may share one directory.
+ */
+class CompileCache {
+public:
+    static const uint64_t DEFAULT_MAX_BYTES = (uint64_t)256 << 20;
+
+    /**
+     * One output of a compilation, e.g. {"llvm_ir", <IR text>}
+     */
+    struct Entry {
+        std::string name;
+        std::string content;
+    };
+
+    /**
+     * @param directory: where entries are kept, created if missing
+     * @param max_bytes: size bound of all the entries
+     */
+    CompileCache(const std::string &directory, uint64_t max_bytes = DEFAULT_MAX_BYTES);
+
+    /**
+     * @param flags: the options that change the outputs, in a fixed order
+     * @param entries: set to the cached outputs on a hit
+     * @return whether the outputs of this source and flags are cached
+     */
+    bool lookup(std::string_view source, const std::string &flags, std::vector<Entry> &entries);
+
+    void store(std::string_view source, const std::string &flags, const std::vector<Entry> &entries);
+
+    uint64_t hits() const { return hit_count; }
+
+    uint64_t misses() const { return miss_count; }
+
+private:
+    std::string key(std::string_view source, const std::string &flags) const;
+
+    std::string path_of(const std::string &key) const;
+
+    /**
+     * Remove the least recently used entries until the directory fits in max_bytes
+     */
+    void evict();
+
+private:
+    std::string directory;
+    uint64_t max_bytes;
+    std::atomic<uint64_t> hit_count{0};
+    std::atomic<uint64_t> miss_count{0};
+    std::atomic<uint64_t> temp_counter{0};
+};
+
+#endif  // CSC4180_COMPILE_CACHE_HPP
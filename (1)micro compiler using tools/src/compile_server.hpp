@@ -0,0 +1,62 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file defines the compile server, which keeps a compiler resident and runs the command lines sent by
+ * thin clients over a Unix domain socket.
+ */
+
+#ifndef CSC4180_COMPILE_SERVER_HPP
+#define CSC4180_COMPILE_SERVER_HPP
+
+#include <functional>
+#include <string>
+
+/**
+ * Runs one command line, as main() would
+ * @return exit status of the command
+ */
+typedef std::function<int(int argc, char const *argv[])> CommandHandler;
+
+/**
+ * @param name: name of the compiler binary
+ * @return $CSC4180_SERVER_SOCKET if set, otherwise $XDG_RUNTIME_DIR/csc4180-<name>.sock, or
+ *         /tmp/csc4180-<uid>/<name>.sock in a directory of mode 0700 created on first use; empty if that
+ *         directory exists but is not private to this user
+ */
+std::string default_socket_path(const std::string &name);
+
+/**
+ * Accept clients on a Unix domain socket and run their command lines, one at a time, until killed
+ *
+ * A client sends its working directory, its arguments, and its stdin/stdout/stderr as file descriptors
+ * (SCM_RIGHTS). While a command runs, the server works in that directory with those descriptors as its
+ * own 0, 1 and 2, so the command reads and writes exactly what it would in the client process; the exit
+ * status is sent back. The socket file is created with mode 0700 and clients of another user are refused.
+ *
+ * @param socket_path: socket to listen on, a stale socket file left by a dead server is replaced
+ * @param handler: runs a command line
+ * @return -1 if the socket cannot be set up
+ */
+int serve(const std::string &socket_path, const CommandHandler &handler);
+
+/**
+ * Client side: run a command line on the server listening on socket_path
+ * A server of another user is refused, with status -1.
+ * @param status: set to the exit status of the command
+ * @return false if no server is listening
+ */
+bool forward(const std::string &socket_path, int argc, char const *argv[], int &status);
+
+/**
+ * main() of a thin client, drop-in compatible with the command line of the compiler binary: the command
+ * runs on the server if one is listening, otherwise the compiler binary next to the client is executed
+ * @param name: name of the compiler binary
+ */
+int run_client(const std::string &name, int argc, char const *argv[]);
+
+#endif  // CSC4180_COMPILE_SERVER_HPP
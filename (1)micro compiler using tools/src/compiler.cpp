@@ -0,0 +1,152 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 20th, 2026
+ *
+ * This file implements the reentrant compiler API defined in compiler.hpp
+ */
+
+#include "compiler.hpp"
+#include "parser.hpp"
+#include "ir_generator.hpp"
+#include "riscv_generator.hpp"
+
+// defined in scanner.l
+yyscan_t open_scanner(std::string_view source, ParserContext* context);    // source must be followed by two NULs
+void close_scanner(yyscan_t scanner);
+int yylex(YYSTYPE* yylval, yyscan_t scanner);
+
+/**
+ * Scan the whole source on its own, for --stats: yyparse pulls tokens as it goes, so the scanner
+ * cannot be timed apart from the parser otherwise
+ * @return number of tokens, SCANEOF included
+ */
+static uint64_t count_tokens(std::string_view text, Arena &arena) {
+    ParserContext context(arena);
+    yyscan_t scanner = open_scanner(text, &context);
+    YYSTYPE yylval;
+    uint64_t tokens = 0;
+    for (int token = yylex(&yylval, scanner); token != 0; token = yylex(&yylval, scanner)) {
+        ++tokens;
+        if (token == TOK_SCANEOF) break;
+    }
+    close_scanner(scanner);
+    return tokens;
+}
+
+// the options that change the outputs, part of the cache key
+static std::string cache_flags(const Options &options) {
+    std::string flags = "micro";
+    flags += options.cst_only ? ";cst" : "";
+    flags += options.emit_dot ? ";dot" : "";
+    flags += options.emit_llvm_ir ? ";ll" : "";
+    flags += options.emit_riscv_asm ? ";asm" : "";
+    return flags;
+}
+
+/**
+ * Fill the outputs of a Result from the cache
+ * @return whether the cache had them
+ */
+static bool lookup_cache(std::string_view source, const Options &options, Result &result) {
+    std::vector<CompileCache::Entry> entries;
+    if (!options.cache->lookup(source, cache_flags(options), entries)) return false;
+    for (auto &entry : entries) {
+        if (entry.name == "errors") result.errors = std::move(entry.content);
+        else if (entry.name == "dot") result.dot = std::move(entry.content);
+        else if (entry.name == "llvm_ir") result.llvm_ir = std::move(entry.content);
+        else if (entry.name == "riscv_asm") result.riscv_asm = std::move(entry.content);
+    }
+    result.success = true;
+    return true;
+}
+
+static void store_cache(std::string_view source, const Options &options, const Result &result) {
+    options.cache->store(source, cache_flags(options), {
+        {"errors", result.errors},
+        {"dot", result.dot},
+        {"llvm_ir", result.llvm_ir},
+        {"riscv_asm", result.riscv_asm},
+    });
+}
+
+Result compile(std::string_view source, const Options &options) {
+    Result result;
+    Stats* stats = options.collect_stats ? &result.stats : nullptr;
+    ParserContext context(result.arena);
+    context.scan_only = options.scan_only ? 1 : 0;
+    context.cst_only = options.cst_only ? 1 : 0;
+    // lexemes are views into this copy, so the tree does not depend on the caller's buffer
+    std::string_view text = result.arena.copy(source, 2);
+    if (options.scan_only) {
+        PhaseTimer lex_timer(stats, "lex");
+        yyscan_t scanner = open_scanner(text, &context);
+        YYSTYPE yylval;
+        while (yylex(&yylval, scanner)) result.stats.tokens++;     // keep extracting tokens from flex scanner
+        close_scanner(scanner);
+        result.tokens = context.tokens.str();
+        lex_timer.stop(result.tokens.size());
+        result.stats.tokens++;      // SCANEOF
+        result.success = true;
+        return result;
+    }
+    bool use_cache = options.cache != nullptr;
+    if (use_cache) {
+        PhaseTimer cache_timer(stats, "cache");
+        bool hit = lookup_cache(source, options, result);
+        result.stats.cache = hit ? "hit" : "miss";
+        cache_timer.stop();
+        if (hit) return result;
+    }
+    if (stats != nullptr) {
+        PhaseTimer lex_timer(stats, "lex");
+        stats->tokens = count_tokens(text, result.arena);
+        lex_timer.stop();
+    }
+    // the parser scans the source again as it goes
+    PhaseTimer parse_timer(stats, "parse");
+    yyscan_t scanner = open_scanner(text, &context);
+    int status = yyparse(scanner, &context);
+    close_scanner(scanner);
+    result.ast = context.root_node;
+    result.errors = context.errors;
+    result.success = status == 0 && result.ast != nullptr;
+    // flattened once, the lexemes stay spans of the source copy in the arena
+    result.flat_ast = FlatAst(result.ast, text);
+    parse_timer.stop();
+    if (stats != nullptr) stats->nodes = result.flat_ast.size();
+    // Dump token class for CST and lexeme for AST
+    if (options.emit_dot) {
+        PhaseTimer dot_timer(stats, "dot");
+        OutputBuffer dot;
+        export_parse_tree_to_dot(result.flat_ast, dot, !options.cst_only);
+        result.dot = dot.str();
+        dot_timer.stop(result.dot.size());
+    }
+    // cst-only should not pursue IR Generation
+    if (!options.cst_only && options.emit_llvm_ir) {
+        PhaseTimer ir_timer(stats, "llvm_ir");
+        OutputBuffer ir;
+        IR_Generator(ir).export_ast_to_llvm_ir(result.flat_ast);
+        result.llvm_ir = ir.str();
+        ir_timer.stop(result.llvm_ir.size());
+    }
+    if (!options.cst_only && options.emit_riscv_asm) {
+        PhaseTimer asm_timer(stats, "riscv_asm");
+        OutputBuffer riscv_asm;
+        RISCV_Generator(riscv_asm).export_ast_to_riscv_asm(result.flat_ast);
+        result.riscv_asm = riscv_asm.str();
+        asm_timer.stop(result.riscv_asm.size());
+    }
+    // failed compilations are not kept, their errors are cheap to reproduce
+    if (use_cache && result.success) {
+        PhaseTimer store_timer(stats, "cache");
+        store_cache(source, options, result);
+        store_timer.stop();
+    }
+    if (stats != nullptr) stats->arena_bytes = result.arena.capacity();
+    return result;
+}
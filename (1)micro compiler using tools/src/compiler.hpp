@@ -0,0 +1,80 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 20th, 2026
+ *
+ * This file defines the reentrant compiler API. One call compiles one Micro source held in memory
+ * and keeps no global state, so several sources can be compiled on different threads at once.
+ */
+
+#ifndef CSC4180_COMPILER_HPP
+#define CSC4180_COMPILER_HPP
+
+#include <string>
+#include <string_view>
+
+#include "arena.hpp"
+#include "compile_cache.hpp"
+#include "flat_ast.hpp"
+#include "node.hpp"
+#include "output_buffer.hpp"
+#include "stats.hpp"
+
+/**
+ * What to produce for a source program
+ */
+struct Options {
+    bool scan_only = false;         // only produce the <token-class, lexeme> pairs, no parsing operations onwards
+    bool cst_only = false;          // build the concrete syntax tree only, no LLVM IR
+    bool emit_dot = true;           // dump the parse tree as .dot content
+    bool emit_llvm_ir = true;
+    bool emit_riscv_asm = false;    // native RISC-V 64 assembly, see riscv_generator.hpp
+    bool collect_stats = false;     // measure every phase into Result::stats, scanning is then done twice
+    CompileCache* cache = nullptr;  // reuse the outputs of an earlier compilation of the same source and options
+};
+
+/**
+ * Everything produced for a source program, each output is empty unless requested in Options
+ * When the outputs come from the cache, the source is not parsed and there is no ast.
+ */
+struct Result {
+    bool success = false;
+    Arena arena;                    // the parse tree and a copy of the source, released with the Result
+    Node* ast = nullptr;            // root of the parse tree (the CST with cst_only), lives in the arena
+    FlatAst flat_ast;               // the same tree as parallel arrays, which every pass after parsing walks
+    std::string tokens;
+    std::string dot;
+    std::string llvm_ir;
+    std::string riscv_asm;
+    std::string errors;             // syntax errors, one per line
+    Stats stats;                    // with collect_stats
+};
+
+/**
+ * State of one scanner/parser run, which used to be globals
+ * The flex scanner sees it as yyextra and the bison parser takes it as a parse-param.
+ */
+struct ParserContext {
+    explicit ParserContext(Arena &arena)
+        : arena(arena) {}
+
+    Arena &arena;                   // where the parser allocates nodes
+    int scan_only = 0;
+    int cst_only = 0;
+    Node* root_node = nullptr;
+    OutputBuffer tokens;            // token information, recorded only with scan_only
+    std::string errors;
+};
+
+/**
+ * Compile a Micro source program
+ * @param source: text of the source program, it is copied into the arena of the Result and not kept
+ * @param options: which outputs to produce
+ * @return the requested outputs
+ */
+Result compile(std::string_view source, const Options &options);
+
+#endif  // CSC4180_COMPILER_HPP
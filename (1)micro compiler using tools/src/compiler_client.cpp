@@ -0,0 +1,17 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file defines the main function of compiler_client, which takes the command line of the compiler
+ * and runs it on a resident `compiler --serve`.
+ */
+
+#include "compile_server.hpp"
+
+int main(int argc, char const *argv[]) {
+    return run_client("compiler", argc, argv);
+}
@@ -0,0 +1,69 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file implements the flattening of a Node tree into the FlatAst defined in flat_ast.hpp
+ */
+
+#include "flat_ast.hpp"
+
+#include <functional>
+
+FlatAst::FlatAst(Node* root, std::string_view source)
+    : source(source) {
+    if (root == nullptr) return;
+    // Explicit stack of the nodes whose children are being added, so the depth of the tree is only
+    // bounded by memory; last_child is where the next child gets linked in
+    struct Frame {
+        Node* node;
+        uint32_t index;
+        size_t next_child;
+        uint32_t last_child;
+    };
+    std::vector<Frame> stack;
+    std::less<const char*> before;
+    auto add = [&](Node* node) {
+        uint32_t index = size();
+        std::string_view text = is_terminal_symbol(node->symbol_class) ? node->lexeme : std::string_view();
+        uint32_t offset;
+        if (text.empty()) {
+            offset = 0;
+        } else if (!before(text.data(), source.data()) && !before(source.data() + source.size(), text.data() + text.size())) {
+            offset = text.data() - source.data();
+        } else {
+            offset = source.size() + extra_text.size();
+            extra_text += text;
+        }
+        symbol_class.push_back(node->symbol_class);
+        lexeme_offset.push_back(offset);
+        lexeme_length.push_back(text.size());
+        first_child.push_back(NONE);
+        next_sibling.push_back(NONE);
+        subtree_end.push_back(NONE);
+        if (!stack.empty()) {
+            Frame &parent = stack.back();
+            if (parent.last_child == NONE) {
+                first_child[parent.index] = index;
+            } else {
+                next_sibling[parent.last_child] = index;
+            }
+            parent.last_child = index;
+        }
+        stack.push_back({node, index, 0, NONE});
+    };
+    add(root);
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        if (frame.next_child < frame.node->children.size()) {
+            Node* child = frame.node->children[frame.next_child++];
+            if (child != nullptr) add(child);
+            continue;
+        }
+        subtree_end[frame.index] = size();
+        stack.pop_back();
+    }
+}
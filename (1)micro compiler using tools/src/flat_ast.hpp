@@ -0,0 +1,161 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file defines the struct-of-arrays form of the parse tree, which the tree passes walk instead of Node pointers.
+ */
+
+#ifndef CSC4180_FLAT_AST_HPP
+#define CSC4180_FLAT_AST_HPP
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "node.hpp"
+
+class NodeRef;
+
+/**
+ * Parse tree as parallel arrays, one entry per node, built once from the Node tree after parsing
+ *
+ * Nodes are numbered in pre-order (the node ids of the .dot file), so the subtree of node i is the index range
+ * [i, subtree_end[i]) and a pass over a subtree is a forward scan through contiguous memory.
+ * The lexeme of a terminal is a span of the source text, the lexeme of a non-terminal is its symbol class name.
+ */
+struct FlatAst {
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    std::vector<SymbolClass> symbol_class;
+    std::vector<uint32_t> lexeme_offset;    // offset in the source text, or in extra_text past its end
+    std::vector<uint32_t> lexeme_length;
+    std::vector<uint32_t> first_child;      // NONE for leaves, i + 1 otherwise
+    std::vector<uint32_t> next_sibling;     // NONE for the last child
+    std::vector<uint32_t> subtree_end;      // one past the last node of the subtree
+
+    std::string_view source;                // text the lexeme spans refer to, not owned
+    std::string extra_text;                 // lexemes that are not part of the source, like folded literals
+
+    FlatAst() = default;
+
+    /**
+     * Flatten a tree in pre-order, null children are left out
+     * @param root: root of the Node tree, may be null for an empty tree
+     * @param source: text most lexemes are views of, they are stored as spans of it; others are copied
+     */
+    explicit FlatAst(Node* root, std::string_view source = {});
+
+    size_t size() const { return symbol_class.size(); }
+    bool empty() const { return symbol_class.empty(); }
+
+    /**
+     * @return the node with the given index, 0 is the root
+     */
+    NodeRef node(uint32_t index) const;
+
+    NodeRef root() const;
+
+    std::string_view lexeme(uint32_t index) const {
+        if (!is_terminal_symbol(symbol_class[index])) return symbol_class_name(symbol_class[index]);
+        uint32_t offset = lexeme_offset[index];
+        if (offset < source.size()) return source.substr(offset, lexeme_length[index]);
+        return std::string_view(extra_text).substr(offset - source.size(), lexeme_length[index]);
+    }
+};
+
+/**
+ * Handle of one node of a FlatAst, with the same accessors as a Node, for passes written against the pointer tree
+ * It is two words and copied by value; it stays valid as long as the FlatAst is not modified or moved.
+ */
+class NodeRef {
+public:
+    /**
+     * Iterates the children of a node through the sibling links
+     */
+    class ChildIterator {
+    public:
+        ChildIterator(const FlatAst* ast, uint32_t index)
+            : ast(ast), index(index) {}
+
+        NodeRef operator*() const { return NodeRef(ast, index); }
+        ChildIterator &operator++() {
+            index = ast->next_sibling[index];
+            return *this;
+        }
+        bool operator!=(const ChildIterator &other) const { return index != other.index; }
+
+    private:
+        const FlatAst* ast;
+        uint32_t index;
+    };
+
+    struct ChildRange {
+        ChildIterator first;
+        ChildIterator begin() const { return first; }
+        ChildIterator end() const { return ChildIterator(nullptr, FlatAst::NONE); }
+    };
+
+    NodeRef(const FlatAst* ast, uint32_t index)
+        : ast(ast), position(index) {}
+
+    uint32_t index() const { return position; }
+    SymbolClass symbol_class() const { return ast->symbol_class[position]; }
+    std::string_view lexeme() const { return ast->lexeme(position); }
+
+    /**
+     * @return index one past the last node of the subtree, the subtree is [index(), subtree_end())
+     */
+    uint32_t subtree_end() const { return ast->subtree_end[position]; }
+
+    ChildRange children() const { return ChildRange{ChildIterator(ast, ast->first_child[position])}; }
+
+    /**
+     * The k-th child, reached by following k sibling links: walk long child lists with children() instead
+     * @param k: index of the child, it must exist
+     */
+    NodeRef child(size_t k) const {
+        uint32_t index = ast->first_child[position];
+        for (; k > 0; --k) index = ast->next_sibling[index];
+        return NodeRef(ast, index);
+    }
+
+    /**
+     * @return the number of children, counted through the sibling links
+     */
+    size_t child_count() const {
+        size_t count = 0;
+        for (uint32_t index = ast->first_child[position]; index != FlatAst::NONE; index = ast->next_sibling[index])
+            ++count;
+        return count;
+    }
+
+    /**
+     * @return the value of an INTLITERAL node
+     */
+    int int_value() const {
+        std::string_view text = lexeme();
+        int value = 0;
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return value;
+    }
+
+private:
+    const FlatAst* ast;
+    uint32_t position;
+};
+
+inline NodeRef FlatAst::node(uint32_t index) const {
+    return NodeRef(this, index);
+}
+
+inline NodeRef FlatAst::root() const {
+    return NodeRef(this, 0);
+}
+
+#endif  // CSC4180_FLAT_AST_HPP
@@ -0,0 +1,130 @@
+# CUHK-SZ CSC4180: Compiler Construction
+# Assignment 1: Micro Language Compiler
+# Author: HaoLUO
+# Date: October 24th, 2026
+#
+# Generator of large valid Micro programs for stress tests and scaling benchmarks.
+# The program is evaluated while it is generated, so its expected output comes with it.
+#
+# Usage: python3 gen_micro.py [options] program.m
+#   writes program.m, its input (--input, default <program>.txt) and its expected output (--expected)
+
+import argparse
+import random
+
+LIMIT = 10 ** 8         # every value stays within +-LIMIT, far from i32 overflow
+
+class Generator:
+    """
+    Builds a Micro program statement by statement, keeping the value every variable holds at that point
+    """
+    def __init__(self, rng, num_variables, depth, list_length):
+        self.rng = rng
+        self.names = ["v%d" % i for i in range(num_variables)]
+        self.values = {}        # variable name -> current value, only for variables already assigned
+        self.depth = depth
+        self.list_length = list_length
+        self.inputs = []        # numbers consumed by read statements, in order
+        self.outputs = []       # lines printed by write statements
+
+    def term(self, depth):
+        """
+        primary: ( expression ) | ID | INTLITERAL
+        @return (text, value)
+        """
+        choice = self.rng.random()
+        if depth > 0 and choice < 0.3:
+            text, value = self.expression(depth - 1)
+            if abs(value) <= LIMIT:
+                return "(" + text + ")", value
+        elif self.values and choice < 0.75:
+            name = self.rng.choice(list(self.values))
+            return name, self.values[name]
+        value = self.rng.randint(0, 999)
+        return str(value), value
+
+    def expression(self, depth):
+        """
+        expression: primary | expression + primary | expression - primary
+        A left-deep chain of terms, an operator is chosen to bring a large running total back to zero
+        @return (text, value)
+        """
+        text, value = self.term(depth)
+        for _ in range(self.rng.randint(0, 3)):
+            term_text, term_value = self.term(depth)
+            plus = self.rng.random() < 0.5
+            if abs(value) > LIMIT // 2:
+                plus = (value < 0) == (term_value > 0)
+            # spaces around the operator, "x -1" would scan as x followed by the literal -1
+            text += (" + " if plus else " - ") + term_text
+            value += term_value if plus else -term_value
+        return text, value
+
+    def assign(self):
+        name = self.rng.choice(self.names)
+        text, value = self.expression(self.depth)
+        if abs(value) > LIMIT:
+            value = self.rng.randint(0, 999)
+            text = str(value)
+        self.values[name] = value
+        return "%s := %s;" % (name, text)
+
+    def read(self):
+        names = [self.rng.choice(self.names) for _ in range(self.rng.randint(1, self.list_length))]
+        for name in names:
+            value = self.rng.randint(-1000, 1000)
+            self.inputs.append(value)
+            self.values[name] = value
+        return "read(%s);" % ", ".join(names)
+
+    def write(self):
+        texts = []
+        values = []
+        for _ in range(self.rng.randint(1, self.list_length)):
+            text, value = self.expression(self.depth)
+            if abs(value) > LIMIT:
+                continue
+            texts.append(text)
+            values.append(value)
+        if not texts:
+            texts, values = ["0"], [0]
+        self.outputs.append(" ".join(str(value) for value in values))
+        return "write(%s);" % ", ".join(texts)
+
+    def program(self, num_statements):
+        lines = ["begin"]
+        lines.append("  " + self.read())
+        for _ in range(num_statements):
+            choice = self.rng.random()
+            if choice < 0.05:
+                lines.append("  " + self.read())
+            elif choice < 0.2:
+                lines.append("  " + self.write())
+            else:
+                lines.append("  " + self.assign())
+        lines.append("  " + self.write())
+        lines.append("end")
+        return "\n".join(lines) + "\n"
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a valid Micro program with its input and expected output")
+    parser.add_argument("program", help="the .m file to write")
+    parser.add_argument("-n", "--statements", type=int, default=100, help="number of statements")
+    parser.add_argument("-v", "--variables", type=int, default=16, help="number of distinct variables")
+    parser.add_argument("-d", "--depth", type=int, default=3, help="maximum nesting of parenthesized expressions")
+    parser.add_argument("-l", "--list-length", type=int, default=4, help="maximum length of read/write lists")
+    parser.add_argument("-s", "--seed", type=int, default=4180, help="random seed, the same seed gives the same program")
+    parser.add_argument("--input", help="[Default: <program>.txt] input numbers for the read statements")
+    parser.add_argument("--expected", help="[Default: <program>-expected.txt] expected output")
+    args = parser.parse_args()
+    stem = args.program[:-2] if args.program.endswith(".m") else args.program
+    generator = Generator(random.Random(args.seed), max(1, args.variables), args.depth, max(1, args.list_length))
+    with open(args.program, "w") as file:
+        file.write(generator.program(args.statements))
+    with open(args.input or stem + ".txt", "w") as file:
+        file.write(" ".join(str(value) for value in generator.inputs) + "\n")
+    with open(args.expected or stem + "-expected.txt", "w") as file:
+        file.write("".join(line + "\n" for line in generator.outputs))
+
+if __name__ == "__main__":
+    main()
@@ -11,70 +11,58 @@
 
 #include "ir_generator.hpp"
 
-std::vector<std::string> ID_TABLE;
-std::vector<int> tmp_register;
-
 void IR_Generator::export_ast_to_llvm_ir(Node* node) {
-    if (node == nullptr) {
+    export_ast_to_llvm_ir(FlatAst(node));
+}
+
+void IR_Generator::export_ast_to_llvm_ir(const FlatAst& ast) {
+    if (ast.empty()) {
         std::cerr << "Error: the ast is empty!" << std::endl;
         return;
     }
     // Manually set
-    out << "; Declare printf";
-    out << std::endl;
-    out << "declare i32 @printf(i8*, ...)";
-    out << std::endl;
-    out << std::endl;
-    out << "; Declare scanf";
-    out << std::endl;
-    out << "declare i32 @scanf(i8*, ...)";
-    out << std::endl;
-    out << std::endl;
-    out << "define i32 @main() {";
-    out << std::endl;
+    out << "; Declare printf\n";
+    out << "declare i32 @printf(i8*, ...)\n";
+    out << "\n";
+    out << "; Declare scanf\n";
+    out << "declare i32 @scanf(i8*, ...)\n";
+    out << "\n";
+    out << "define i32 @main() {\n";
 
-    gen_llvm_ir(node);
+    this->ast = &ast;
+    gen_llvm_ir(ast.root());
 
-    out << "\tret i32 0";
-    out << std::endl;
-    out << "}";
-    out << std::endl;
+    out << "\tret i32 0\n";
+    out << "}\n";
 
     out.close();
 }
 
-void IR_Generator::gen_llvm_ir(Node* node) {
-    if (node == nullptr) {
-        std::cerr << "Error: AST node is empty" << std::endl;
-        return;
-    }
+void IR_Generator::gen_llvm_ir(NodeRef node) {
     // Seperated functions for different situation
     /*
-    Skip: ID, INTLITERAL
-    Special: ASSIGNOP, READ, WRITE, 
-    Recursive: Others
+    Special: ASSIGNOP, READ, WRITE, their subtrees are skipped afterwards
+    Walk: Others, the nodes are in pre-order so their children come next
     */
-    switch (node->symbol_class) {
-        case SymbolClass::ASSIGNOP:
-            gen_assignop_llvm_ir(node);
-            break;
-        case SymbolClass::READ:
-            gen_read_llvm_ir(node);
-            break;
-        case SymbolClass::WRITE:
-            gen_write_llvm_ir(node);
-            break;
-        case SymbolClass::ID:
-        case SymbolClass::INTLITERAL:
-            break;
-        default:
-            // Recursively generate LLVM IR for each child node
-            for (auto &child : node->children) {
-                gen_llvm_ir(child);
-            }
-            break;
+    uint32_t index = node.index();
+    while (index < node.subtree_end()) {
+        NodeRef current = ast->node(index);
+        switch (current.symbol_class()) {
+            case SymbolClass::ASSIGNOP:
+                gen_assignop_llvm_ir(current);
+                break;
+            case SymbolClass::READ:
+                gen_read_llvm_ir(current);
+                break;
+            case SymbolClass::WRITE:
+                gen_write_llvm_ir(current);
+                break;
+            default:
+                ++index;
+                continue;
+        }
+        index = current.subtree_end();
     }
-    return;
 }
 
 
@@ -85,23 +73,24 @@ void IR_Generator::gen_llvm_ir(Node* node) {
  * %_scanf_str_1 = getelementptr [# x i8], [# x i8]* %_scanf_format_1, i32 0, i32 0
  * call i32 (i8*, ...) @scanf(i8* %_sacnf_str_1, i32* %<variable>)
  */
-void IR_Generator::gen_read_llvm_ir(Node* node) {
+void IR_Generator::gen_read_llvm_ir(NodeRef node) {
     std::string variable_list = "";
     std::string format_info = "";
-    for (int i = 0; i < node->children.size(); i++) {
-        std::string variable = node->children[i]->lexeme;
+    for (NodeRef child : node.children()) {
+        std::string variable(child.lexeme());
         bool flag = 1;
-        for (int j = 0; j < ID_TABLE.size(); j++){
-            if (variable == ID_TABLE[j]){
+        for (int j = 0; j < id_table.size(); j++){
+            if (variable == id_table[j]){
                 flag = 0;
                 break;
             }
         }
         if (flag){
-            ID_TABLE.push_back(variable);
-            out << "\t%" << variable << " = alloca i32" << std::endl;
-            variable_list += ", i32* %" + variable;
+            id_table.push_back(variable);
+            out << "\t%" << variable << " = alloca i32\n";
         }
+        // a variable read again is stored to as well
+        variable_list += ", i32* %" + variable;
         format_info += "%d ";
     }
     format_info = std::string(format_info.begin(), format_info.end() - 1);
@@ -109,10 +98,12 @@ void IR_Generator::gen_read_llvm_ir(Node* node) {
     int i8_num = format_info.length() + 1;
     std::string i8_string = std::to_string(i8_num) + " x i8";
 
-    out << "\t%_scanf_format_1 = alloca [" << i8_string << "]" << std::endl;
-    out << "\tstore [" << i8_string << "] c\"" << format_info << "\\00\", [" << i8_string << "]* %_scanf_format_1" << std::endl;
-    out << "\t%_scanf_str_1 = getelementptr [" << i8_string << "], [" << i8_string << "]* %_scanf_format_1, i32 0, i32 0" << std::endl;
-    out << "\tcall i32 (i8*, ...) @scanf(i8* %_scanf_str_1" << variable_list << ")" << std::endl;
+    // every read statement has its own format string
+    std::string id = std::to_string(++format_counter);
+    out << "\t%_scanf_format_" << id << " = alloca [" << i8_string << "]\n";
+    out << "\tstore [" << i8_string << "] c\"" << format_info << "\\00\", [" << i8_string << "]* %_scanf_format_" << id << "\n";
+    out << "\t%_scanf_str_" << id << " = getelementptr [" << i8_string << "], [" << i8_string << "]* %_scanf_format_" << id << ", i32 0, i32 0\n";
+    out << "\tcall i32 (i8*, ...) @scanf(i8* %_scanf_str_" << id << variable_list << ")\n";
 }
 
 
@@ -122,8 +113,8 @@ void IR_Generator::gen_read_llvm_ir(Node* node) {
  * %_printf_str_1 = getelementptr [# x i8], [# x i8]* %_printf_format_1, i32 0, i32 0
  * call i32 (i8*, ...) @printf(i8* %_printf_str_1, i32 <rvalue>)
  */
-void IR_Generator::gen_write_llvm_ir(Node* node) {
-    int variable_num = node->children.size();
+void IR_Generator::gen_write_llvm_ir(NodeRef node) {
+    int variable_num = node.child_count();
 
     std::string format_info = "";
     for (int i = 0; i < variable_num; i++) {
@@ -134,20 +125,21 @@ void IR_Generator::gen_write_llvm_ir(Node* node) {
     int i8_num = format_info.length() + 2;
     std::string i8_string = std::to_string(i8_num) + " x i8";
 
-    out << "\t%_printf_format_1 = alloca [" << i8_string << "]" << std::endl;
-    out << "\tstore [" << i8_string << "] c\"" << format_info << "\\0A\\00\", [" << i8_string << "]* %_printf_format_1" << std::endl;
-    out << "\t%_printf_str_1 = getelementptr [" << i8_string << "], [" << i8_string << "]* %_printf_format_1, i32 0, i32 0" << std::endl;
+    std::string id = std::to_string(++format_counter);
+    out << "\t%_printf_format_" << id << " = alloca [" << i8_string << "]\n";
+    out << "\tstore [" << i8_string << "] c\"" << format_info << "\\0A\\00\", [" << i8_string << "]* %_printf_format_" << id << "\n";
+    out << "\t%_printf_str_" << id << " = getelementptr [" << i8_string << "], [" << i8_string << "]* %_printf_format_" << id << ", i32 0, i32 0\n";
     
     std::string variable_list = "";
-    for (int i = 0; i < node->children.size(); i++) {
-        switch (node->children[i]->symbol_class) {
+    for (NodeRef child : node.children()) {
+        switch (child.symbol_class()) {
             case SymbolClass::ID:
             case SymbolClass::INTLITERAL:
-                variable_list += ", i32 " + reference(node->children[i]);
+                variable_list += ", i32 " + reference(child);
                 break;
             case SymbolClass::PLUSOP:
             case SymbolClass::MINUSOP:
-                variable_list += ", i32 " + combine(node->children[i]);
+                variable_list += ", i32 " + combine(child);
                 break;
             default:{
                 std::cerr << "Invalid operand!" << std::endl;
@@ -155,34 +147,26 @@ void IR_Generator::gen_write_llvm_ir(Node* node) {
             }
         }
     }
-    out << "\tcall i32 (i8*, ...) @printf(i8* %_printf_str_1" << variable_list << ")" << std::endl;
+    out << "\tcall i32 (i8*, ...) @printf(i8* %_printf_str_" << id << variable_list << ")\n";
 }
 
 
-// Get the available register
+// Get the available register, registers are never released so they are simply numbered
 std::string IR_Generator::find_tmp_register(){
-    int l = tmp_register.size(); 
-    for (int i = 0; i < l; ++i){
-        if (tmp_register[i] == 0){
-            tmp_register[i] = 1;
-            return std::to_string(i+1);
-        }
-    }
-    tmp_register.push_back(1);
-    return std::to_string(l+1);
+    return std::to_string(++tmp_counter);
 }
 
 // When an intger of variable is referenced
-std::string IR_Generator::reference(Node* node){
-    switch (node->symbol_class) {
+std::string IR_Generator::reference(NodeRef node){
+    switch (node.symbol_class()) {
         case SymbolClass::ID:{
             std::string temp_variable = "%_tmp_" + find_tmp_register();
-            out << "\t" << temp_variable << " = load i32, i32* %" << node->lexeme << std::endl;
+            out << "\t" << temp_variable << " = load i32, i32* %" << node.lexeme() << '\n';
             return temp_variable;
             break;
         }
         case SymbolClass::INTLITERAL:{
-            return node->lexeme;
+            return std::string(node.lexeme());
             break;
         }
         default:
@@ -193,66 +177,50 @@ std::string IR_Generator::reference(Node* node){
 }
 
 // Combine the varibles and operations, left child-node-right child
-std::string IR_Generator::combine(Node* node){
-    std::string operation = "";
-    switch (node->symbol_class){
-        case SymbolClass::PLUSOP:{
-            operation = "add";
-            break;
-        }
-        case SymbolClass::MINUSOP:{
-            operation = "sub";
-            break;
-        }
-        default:{
-            std::cerr << "Error oprand!" << std::endl;
-            break;
-        }
-    }
-    std::string lvalue;
-    std::string rvalue;
-    Node* left_child = node->children[0];
-    Node* right_child = node->children[1];
-    switch (left_child->symbol_class){
-        case SymbolClass::ID:{
-            lvalue = reference(left_child);
-            break;
-        }
-        case SymbolClass::INTLITERAL:{
-            lvalue = reference(left_child);
-            break;
-        }
-        case SymbolClass::PLUSOP:
-        case SymbolClass::MINUSOP:
-            lvalue = combine(left_child);
-            break;
-        default:{
-            std::cerr << "Error oprand!" << std::endl;
-            break;
-        }
-    }
-
-    switch (right_child->symbol_class){
-        case SymbolClass::ID:{
-            rvalue = reference(right_child);
-            break;
-        }
-        case SymbolClass::INTLITERAL:{
-            rvalue = reference(right_child);
-            break;
-        }
-        case SymbolClass::PLUSOP:
-        case SymbolClass::MINUSOP:
-            rvalue = combine(right_child);
-            break;
-        default:{
-            std::cerr << "Error oprand!" << std::endl;
-            break;
+// Post-order walk with an explicit stack of tasks and a stack of operand values, so that
+// arbitrarily deep expressions use no call stack; the instructions are the same as a recursive walk's
+std::string IR_Generator::combine(NodeRef node){
+    struct Task {
+        NodeRef node;
+        bool operands_ready;    // both operands are on the value stack, emit the operation
+    };
+    std::vector<Task> tasks{{node, false}};
+    std::vector<std::string> values;
+    while (!tasks.empty()) {
+        Task task = tasks.back();
+        tasks.pop_back();
+        NodeRef current = task.node;
+        switch (current.symbol_class()){
+            case SymbolClass::ID:
+            case SymbolClass::INTLITERAL:
+                values.push_back(reference(current));
+                break;
+            case SymbolClass::PLUSOP:
+            case SymbolClass::MINUSOP:{
+                if (!task.operands_ready) {
+                    tasks.push_back({current, true});
+                    tasks.push_back({current.child(1), false});
+                    tasks.push_back({current.child(0), false});
+                    break;
+                }
+                std::string operation = current.symbol_class() == SymbolClass::PLUSOP ? "add" : "sub";
+                std::string rvalue = std::move(values.back());
+                values.pop_back();
+                std::string lvalue = std::move(values.back());
+                values.pop_back();
+                std::string temp_variable = "%_tmp_" + find_tmp_register();
+                out << "\t" << temp_variable << " = " << operation << " i32 " << lvalue << ", " << rvalue << '\n';
+                values.push_back(temp_variable);
+                break;
+            }
+            default:{
+                std::cerr << "Error oprand!" << std::endl;
+                values.push_back("");
+                break;
+            }
         }
     }
-    std::string temp_variable = "%_tmp_" + find_tmp_register();
-    out << "\t" << temp_variable << " = " << operation << " i32 " << lvalue << ", " << rvalue << std::endl;
-    return temp_variable;
+    return values.back();
 }
 
 /*
@@ -260,18 +228,18 @@ std::string IR_Generator::combine(Node* node){
  * %* = alloca i32
  * store i32 value, i32* %*
  */
-void IR_Generator::gen_assignop_llvm_ir(Node* node){
-    std::string variable = node->children[0]->lexeme; // The variable name
+void IR_Generator::gen_assignop_llvm_ir(NodeRef node){
+    std::string variable(node.child(0).lexeme()); // The variable name
     std::string right_value;
 
-    switch (node->children[1]->symbol_class) {
+    switch (node.child(1).symbol_class()) {
         case SymbolClass::ID:
         case SymbolClass::INTLITERAL:
-            right_value = reference(node->children[1]);
+            right_value = reference(node.child(1));
             break;
         case SymbolClass::PLUSOP:
         case SymbolClass::MINUSOP:
-            right_value = combine(node->children[1]);
+            right_value = combine(node.child(1));
             break;
         default:{
             std::cerr << "Invalid symbol!" <<std::endl;
@@ -280,17 +248,17 @@ void IR_Generator::gen_assignop_llvm_ir(Node* node){
     }
     // Check whether need to declear
     bool flag = 1;
-    for (int j = 0; j < ID_TABLE.size(); j++){
-        if (variable == ID_TABLE[j]){
+    for (int j = 0; j < id_table.size(); j++){
+        if (variable == id_table[j]){
             flag = 0;
             break;
         }
     }
     if (flag){
         // variable not in the table
-        ID_TABLE.push_back(variable);
-        out << "\t%" << variable << " = alloca i32" << std::endl;        
+        id_table.push_back(variable);
+        out << "\t%" << variable << " = alloca i32\n";        
     }
-    out << "\tstore i32 " << right_value << ", i32* %" << variable << std::endl;
+    out << "\tstore i32 " << right_value << ", i32* %" << variable << '\n';
 }
 
@@ -12,7 +12,12 @@
 #ifndef CSC4180_IR_GENERATOR_HPP
 #define CSC4180_IR_GENERATOR_HPP
 
+#include <string>
+#include <vector>
+
+#include "flat_ast.hpp"
 #include "node.hpp"
+#include "output_buffer.hpp"
 
 /**
  * LLVM IR Generator of Micro Language
@@ -20,43 +25,57 @@
  */
 class IR_Generator {
 public:
-    IR_Generator(std::ofstream &output)
+    /**
+     * @param output: IR is appended to this buffer, pass a memory-mode OutputBuffer to keep the IR in memory
+     */
+    IR_Generator(OutputBuffer &output)
         : out(output) {}
 
     /**
      * Export AST to LLVM IR file
      * 
-     * It calls gen_llvm_ir recursively to generate LLVM IR instruction for each node in the AST
+     * It calls gen_llvm_ir to generate LLVM IR instruction for each node in the AST
      * 
-     * @param node
+     * @param ast: the flattened AST
+     * @return
+     */
+    void export_ast_to_llvm_ir(const FlatAst& ast);
+
+    /**
+     * Same as above for a Node tree, which is flattened first
+     * @param node: root of the AST
      * @return
      */
     void export_ast_to_llvm_ir(Node* node);
 
 private:
     /**
-     * Recursively generate LLVM IR of the given AST tree node
+     * Generate LLVM IR of the given AST tree node and its subtree
      * 
      * Should have different logic for different symbol classes
      * 
-     * this should be a recursive function
+     * The subtree is scanned forward in pre-order, skipping the subtrees of statements once generated
      */
-    void gen_llvm_ir(Node* node);
+    void gen_llvm_ir(NodeRef node);
 
-    void gen_read_llvm_ir(Node* node);
+    void gen_read_llvm_ir(NodeRef node);
 
-    void gen_write_llvm_ir(Node* node);
+    void gen_write_llvm_ir(NodeRef node);
 
     std::string find_tmp_register();
 
-    std::string reference(Node* node);
+    std::string reference(NodeRef node);
 
-    std::string combine(Node* node);
+    std::string combine(NodeRef node);
 
-    void gen_assignop_llvm_ir(Node* node);
+    void gen_assignop_llvm_ir(NodeRef node);
 
 private:
-    std::ofstream &out;
+    OutputBuffer &out;
+    const FlatAst* ast = nullptr;           // the tree being exported
+    std::vector<std::string> id_table;      // variables already allocated with alloca
+    int tmp_counter = 0;                    // %_tmp_<n> registers handed out so far
+    int format_counter = 0;                 // numbers the scanf/printf format strings of read/write statements
 };
 
 #endif  // CSC4180_IR_GENERATOR_HPP
@@ -13,32 +13,102 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <cstring>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
 #include "node.hpp"
-#include "ir_generator.hpp"
+#include "bytecode_vm.hpp"
+#include "compiler.hpp"
+#include "compile_server.hpp"
 
-int scan_only = 0;
-int cst_only = 0;
+namespace po = boost::program_options;
 
-extern int yyparse();
-extern int yylex();
-extern Node* root_node;
+/**
+ * One source program given on the command line, with the files its outputs go to
+ */
+struct Job {
+    std::string source_filename;
+    std::string dot_filename;
+    std::string ir_filename;
+    std::string asm_filename;
+    bool loaded = false;
+    Result result;
+};
 
-namespace po = boost::program_options;
+// test/test0.m -> test/test0<extension>
+static std::string replace_extension(const std::string &filename, const std::string &extension) {
+    size_t slash = filename.find_last_of('/');
+    size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return filename + extension;
+    return filename.substr(0, dot) + extension;
+}
 
-int main(int argc, char const *argv[]) {
+static bool read_source(const std::string &filename, std::string &source) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream content;
+    content << file.rdbuf();
+    source = content.str();
+    return true;
+}
+
+static void write_output(const std::string &filename, const std::string &content) {
+    OutputBuffer out(filename);
+    out << content;
+}
+
+/**
+ * Compile every job on a pool of worker threads
+ * Each worker takes the next job that is not taken yet, compiles it in memory and writes its output files.
+ * Messages meant for stdout are kept in the job and printed by the caller in command line order.
+ */
+static void compile_jobs(std::vector<Job> &jobs, const Options &options, unsigned num_threads) {
+    std::atomic<size_t> next_job(0);
+    auto worker = [&]() {
+        for (size_t i = next_job++; i < jobs.size(); i = next_job++) {
+            Job &job = jobs[i];
+            std::string source;
+            if (!read_source(job.source_filename, source)) continue;
+            job.loaded = true;
+            job.result = compile(source, options);
+            if (options.emit_dot) write_output(job.dot_filename, job.result.dot);
+            if (options.emit_llvm_ir && !options.cst_only) write_output(job.ir_filename, job.result.llvm_ir);
+            if (options.emit_riscv_asm && !options.cst_only) write_output(job.asm_filename, job.result.riscv_asm);
+        }
+    };
+    if (num_threads > jobs.size()) num_threads = jobs.size();
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < num_threads; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+/**
+ * Run one command line of the compiler, in this process or for a client of the compile server
+ * @return exit status
+ */
+static int run_command(int argc, char const *argv[]) {
     po::options_description desc(
 R"(CUHK-SZ CSC4180 Assignment-1: Micro Language Compiler Frontend
-Usage: Usage: compiler [options] source-program.m
+Usage: Usage: compiler [options] source-program.m...
+       compiler --serve [socket]    (compile the command lines of compiler_client)
 Allowed options: )");
     desc.add_options()
-        ("help,h", R"(Usage: Usage: compiler [options] source-program.m)")
+        ("help,h", R"(Usage: Usage: compiler [options] source-program.m...)")
         ("scan-only,s",
             "[Default: false] print out token class and lexeme pairs for each token, no parsing operations onwards")
+        ("run,r",
+            "[Default: false] execute the program in the built-in bytecode interpreter (stdin/stdout), no .dot or LLVM IR output")
         ("cst-only,c",
             "[Default: false] generate concrete syntax tree only, do not generate AST and LLVM IR")
         ("dot,d",
@@ -47,7 +117,26 @@ Allowed options: )");
         ("output,o",
             po::value<std::string>()->default_value("program.ll"),
             "[Default: program.ll] LLVM IR file compiled from source code")
-        ("source-program", po::value<std::string>(), "source Micro program to compile");
+        ("asm,S",
+            po::value<std::string>(),
+            "RISC-V 64 assembly file compiled directly from AST, bypassing LLVM: the .dot and LLVM IR files are "
+            "then only written when --dot or --output names them")
+        ("stats",
+            "[Default: false] print wall/CPU time, allocations, output bytes and peak RSS of every phase to stderr")
+        ("stats-json",
+            "[Default: false] print the same statistics to stderr as one JSON document, for CI")
+        ("cache",
+            po::value<std::string>(),
+            "directory of a compile cache: a program compiled before with the same options is not compiled again")
+        ("cache-size",
+            po::value<unsigned>()->default_value(256),
+            "[Default: 256] size bound of the compile cache in MiB, least recently used programs are dropped")
+        ("jobs,j",
+            po::value<unsigned>()->default_value(0),
+            "[Default: number of cores] number of source programs compiled in parallel")
+        ("source-program", po::value<std::vector<std::string>>(),
+            "source Micro programs to compile, with more than one program the outputs are written next to "
+            "each source as <name>.dot, <name>.ll and <name>.s instead of the filenames above");
     // Positional arguments
     po::positional_options_description p;
     p.add("source-program", -1);
@@ -55,7 +144,8 @@ Allowed options: )");
     po::variables_map vm;
     std::string dot_filename;
     std::string ir_filename;
-    std::string source_filename;
+    std::string asm_filename;
+    std::vector<std::string> source_filenames;
     try {
         po::store(po::command_line_parser(argc, argv).options(desc).positional(p).run(), vm);
         po::notify(vm);
@@ -67,31 +157,98 @@ Allowed options: )");
         std::cout << desc << "\n";
         return 0;
     }
-    if (vm.count("cst-only")) cst_only = 1;
+    Options options;
+    if (vm.count("scan-only")) options.scan_only = true;
+    if (vm.count("cst-only")) options.cst_only = true;
     if (vm.count("dot"))
         dot_filename = vm["dot"].as<std::string>();
     if (vm.count("output"))
         ir_filename = vm["output"].as<std::string>();
+    if (vm.count("asm")) {
+        asm_filename = vm["asm"].as<std::string>();
+        options.emit_riscv_asm = true;
+        // the default .dot and .ll files are not written next to the assembly unless asked for
+        if (vm["dot"].defaulted()) options.emit_dot = false;
+        if (vm["output"].defaulted()) options.emit_llvm_ir = false;
+    }
+    if (vm.count("run") || options.scan_only) {
+        options.emit_dot = false;
+        options.emit_llvm_ir = false;
+        options.emit_riscv_asm = false;
+    }
+    if (vm.count("stats") || vm.count("stats-json")) options.collect_stats = true;
+    // --run executes the parse tree, which the cache does not keep
+    std::unique_ptr<CompileCache> cache;
+    if (vm.count("cache") && !vm.count("run") && !options.scan_only) {
+        cache.reset(new CompileCache(vm["cache"].as<std::string>(), (uint64_t)vm["cache-size"].as<unsigned>() << 20));
+        options.cache = cache.get();
+    }
     if (vm.count("source-program"))
-        source_filename = vm["source-program"].as<std::string>();
+        source_filenames = vm["source-program"].as<std::vector<std::string>>();
     else {
         std::cerr << "No source program file provided.\n";
         return -1;
     }
-    freopen(source_filename.c_str(), "r", stdin);
-    if (vm.count("scan-only")) {
-        scan_only = 1;      // set this flag to enable flex scanner to print out token info
-        while (yylex());    // keep extracting tokens from flex scanner
-        return 0;
+    std::vector<Job> jobs(source_filenames.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        Job &job = jobs[i];
+        job.source_filename = source_filenames[i];
+        bool single = jobs.size() == 1;
+        job.dot_filename = single ? dot_filename : replace_extension(job.source_filename, ".dot");
+        job.ir_filename = single ? ir_filename : replace_extension(job.source_filename, ".ll");
+        job.asm_filename = single ? asm_filename : replace_extension(job.source_filename, ".s");
+    }
+    unsigned num_threads = vm["jobs"].as<unsigned>();
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    compile_jobs(jobs, options, num_threads);
+
+    int status = 0;
+    for (auto &job : jobs) {
+        if (!job.loaded) {
+            std::cerr << "Error: cannot open " << job.source_filename << "\n";
+            status = -1;
+            continue;
+        }
+        std::cout << job.result.tokens << job.result.errors;
+        if (options.emit_dot) std::cout << "export parse tree filename: " << job.dot_filename << "\n";
+        if (vm.count("run")) {
+            // the programs read from stdin one after another
+            Bytecode_VM bytecode_vm;
+            bytecode_vm.compile(job.result.flat_ast);
+            std::cout.flush();
+            OutputBuffer program_output("-");
+            bytecode_vm.run(stdin, program_output);
+        }
+    }
+    if (options.collect_stats) {
+        // after all the output of the compiler, in command line order
+        bool json = vm.count("stats-json") > 0;
+        if (json) std::cerr << "{\"programs\": [";
+        bool first = true;
+        for (auto &job : jobs) {
+            if (!job.loaded) continue;
+            if (json) {
+                std::cerr << (first ? "" : ", ") << stats_to_json(job.source_filename, job.result.stats);
+            } else {
+                std::cerr << stats_to_text(job.source_filename, job.result.stats);
+            }
+            first = false;
+        }
+        if (json) {
+            std::cerr << "]";
+            if (cache) std::cerr << ", \"cache_hits\": " << cache->hits() << ", \"cache_misses\": " << cache->misses();
+            std::cerr << "}\n";
+        } else if (cache) {
+            std::cerr << "compile cache: " << cache->hits() << " hits, " << cache->misses() << " misses\n";
+        }
+    }
+    return status;
+}
+
+int main(int argc, char const *argv[]) {
+    // compiler --serve [socket]: stay resident and run the command lines of compiler_client
+    if (argc >= 2 && std::strcmp(argv[1], "--serve") == 0) {
+        return serve(argc >= 3 ? argv[2] : default_socket_path("compiler"), run_command);
     }
-    yyparse();
-    // Dump token class for CST and lexeme for AST
-    export_parse_tree_to_dot(root_node, dot_filename, vm.count("cst-only") ? false : true);
-    // cst-only should not pursue IR Generation
-    if (vm.count("cst-only")) return 0;
-    std::ofstream ir_output = std::ofstream(ir_filename);
-    auto ir_generator = new IR_Generator(ir_output);
-    ir_generator->export_ast_to_llvm_ir(root_node);
-    delete ir_generator;
-    return 0;
+    return run_command(argc, argv);
 }
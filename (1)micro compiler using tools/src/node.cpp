@@ -11,8 +11,13 @@
  */
 
 #include "node.hpp"
+#include "flat_ast.hpp"
 
 std::string symbol_class_to_str(const SymbolClass &symbol_class) {
+    return std::string(symbol_class_name(symbol_class));
+}
+
+std::string_view symbol_class_name(const SymbolClass &symbol_class) {
     switch (symbol_class) {
         // 14 terminal symbols, noted in upper-case
         case SymbolClass::BEGIN_:           return "BEGIN_";
@@ -99,28 +104,37 @@ bool is_preserved_symbol_for_ast(const SymbolClass &symbol_class) {
     }
 }
 
-void write_parse_tree(std::ofstream& out, Node* node, int& counter, bool export_lexeme) {
-    if (node == nullptr) return;
-    // Create a unique identifier for the node
-    std::string node_id = "node" + std::to_string(counter++);
-    // Write the node
-    out << node_id
-        << " [label=\""
-        << ((export_lexeme) ? node->lexeme : symbol_class_to_str(node->symbol_class))
-        << "\"];\n";
-    // Write connections to children
-    for (auto* child : node->children) {
-        std::string child_id = "node" + std::to_string(counter);
-        write_parse_tree(out, child, counter, export_lexeme);
-        out << node_id << " -> " << child_id << ";\n";
+void write_parse_tree(OutputBuffer& out, const FlatAst& ast, bool export_lexeme) {
+    // open holds the ancestors of the current node; an edge is written once the child's subtree is complete
+    std::vector<uint32_t> open;
+    auto close = [&]() {
+        uint32_t child = open.back();
+        open.pop_back();
+        if (!open.empty()) out << "node" << open.back() << " -> node" << child << ";\n";
+    };
+    for (uint32_t i = 0; i < ast.size(); ++i) {
+        while (!open.empty() && ast.subtree_end[open.back()] <= i) close();
+        out << "node" << i
+            << " [label=\""
+            << ((export_lexeme) ? ast.lexeme(i) : symbol_class_name(ast.symbol_class[i]))
+            << "\"];\n";
+        open.push_back(i);
     }
+    while (!open.empty()) close();
 }
 
 void export_parse_tree_to_dot(Node* root, const std::string& filename, bool export_lexeme) {
     std::cout << "export parse tree filename: " << filename << "\n";
-    std::ofstream out(filename);
+    OutputBuffer out(filename);
+    export_parse_tree_to_dot(FlatAst(root), out, export_lexeme);
+}
+
+void export_parse_tree_to_dot(Node* root, OutputBuffer& out, bool export_lexeme) {
+    export_parse_tree_to_dot(FlatAst(root), out, export_lexeme);
+}
+
+void export_parse_tree_to_dot(const FlatAst& ast, OutputBuffer& out, bool export_lexeme) {
     out << "digraph AST {\n";
-    int counter = 0;
-    write_parse_tree(out, root, counter, export_lexeme);
+    write_parse_tree(out, ast, export_lexeme);
     out << "}";
 }
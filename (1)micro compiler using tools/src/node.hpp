@@ -15,9 +15,16 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "arena.hpp"
+#include "output_buffer.hpp"
+
 /**
  * Define all classes of symbols for Micro language,
  * including both tokens (terminal symbols) and non-terminal symbols
@@ -59,6 +66,13 @@ enum class SymbolClass {
  */
 std::string symbol_class_to_str(const SymbolClass &symbol_class);
 
+/**
+ * Same as symbol_class_to_str, as a view of a string literal
+ * @param symbol_class
+ * @return the string expression of the given symbol class, valid for the whole program
+ */
+std::string_view symbol_class_name(const SymbolClass &symbol_class);
+
 /**
  * Determine whether a symbol is terminal or non-terminal
  * @param symbol_class
@@ -77,27 +91,79 @@ bool is_terminal_symbol(const SymbolClass &symbol_class);
  */
 bool is_preserved_symbol_for_ast(const SymbolClass &symbol_class);
 
+/**
+ * Lexeme passed from the scanner to the parser through yylval
+ * It is a plain view into the source text kept in the arena, since the bison %union cannot hold a std::string_view
+ */
+struct Lexeme {
+    const char* text;
+    size_t length;
+
+    operator std::string_view() const { return std::string_view(text, length); }
+};
+
+struct Node;
+
+/**
+ * Children of a tree node, stored as one contiguous array of node pointers in the arena
+ * When the array is full, appending moves the children into an array twice as large;
+ * the old array stays in the arena until the whole tree is released.
+ */
+struct NodeList {
+    Node** items = nullptr;
+    uint32_t count = 0;
+    uint32_t capacity = 0;
+
+    Node** begin() const { return items; }
+    Node** end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    Node* operator[](size_t i) const { return items[i]; }
+
+    void push_back(Arena &arena, Node* node) {
+        if (count == capacity) {
+            uint32_t new_capacity = capacity == 0 ? 2 : capacity * 2;
+            Node** new_items = (Node**)arena.allocate(new_capacity * sizeof(Node*), alignof(Node*));
+            std::copy(items, items + count, new_items);
+            items = new_items;
+            capacity = new_capacity;
+        }
+        items[count++] = node;
+    }
+};
+
 /**
  * Basic data structure for tree-structure
+ * Nodes are allocated in the arena of their compilation and are never deleted one by one,
+ * the lexeme views the source text (or a string in the same arena)
  */
 struct Node {
     SymbolClass symbol_class;
-    std::string lexeme;
-    std::vector<Node*> children;
+    std::string_view lexeme;
+    NodeList children;
 
-    Node(const SymbolClass &symbol, std::string label = "") {
+    Node(const SymbolClass &symbol, std::string_view label = {}) {
         symbol_class = symbol;
-        lexeme = is_terminal_symbol(symbol) ? label : symbol_class_to_str(symbol);
-        children.resize(0);
+        lexeme = is_terminal_symbol(symbol) ? label : symbol_class_name(symbol);
     }
 
     /**
-     * Append a child node to the children vector
+     * Append a child node to the children array
+     * @param arena: arena of the tree, in case the array has to grow
      * @param child: pointer of the child node to append
      * @return
      */
-    void append_child(Node* child) {
-        this->children.push_back(child);
+    void append_child(Arena &arena, Node* child) {
+        children.push_back(arena, child);
+    }
+
+    /**
+     * @return the value of an INTLITERAL node
+     */
+    int int_value() const {
+        int value = 0;
+        std::from_chars(lexeme.data(), lexeme.data() + lexeme.size(), value);
+        return value;
     }
 
     /**
@@ -110,18 +176,21 @@ struct Node {
     }
 };
 
+struct FlatAst;
+
 /**
- * [Recursive] Write tree structure as Dot content and output as file stream
- * @param out: output file stream
- * @param node
- * @param counter: node counter
+ * Write tree structure as Dot content and output as file stream
+ * The flat tree is in pre-order, so node ids are indices and the tree is written in one forward scan
+ * @param out: output buffer
+ * @param ast: the tree to write
+ * @param export_lexeme: true to export lexeme and false to export token class
  * @return
  */
-void write_parse_tree(std::ofstream& out, Node* node, int& counter, bool export_lexeme);
+void write_parse_tree(OutputBuffer& out, const FlatAst& ast, bool export_lexeme);
 
 /**
  * Export tree structure as a Dot file for visualization
- * It calls the recursive write_parse_tree function.
+ * It flattens the tree and calls write_parse_tree.
  * @param root: the root node of the tree to export
  * @param filename: filename to write to
  * @param export_lexeme: true to export lexeme and false to export token class when dumping tree to dot
@@ -129,4 +198,22 @@ void write_parse_tree(std::ofstream& out, Node* node, int& counter, bool export_
  */
 void export_parse_tree_to_dot(Node* root, const std::string& filename, bool export_lexeme);
 
+/**
+ * Export tree structure as Dot content into an output buffer
+ * @param root: the root node of the tree to export
+ * @param out: output buffer, either file-backed or in memory
+ * @param export_lexeme: true to export lexeme and false to export token class when dumping tree to dot
+ * @return
+ */
+void export_parse_tree_to_dot(Node* root, OutputBuffer& out, bool export_lexeme);
+
+/**
+ * Export a flattened tree as Dot content into an output buffer
+ * @param ast: the tree to export
+ * @param out: output buffer, either file-backed or in memory
+ * @param export_lexeme: true to export lexeme and false to export token class when dumping tree to dot
+ * @return
+ */
+void export_parse_tree_to_dot(const FlatAst& ast, OutputBuffer& out, bool export_lexeme);
+
 #endif  // CSC4180_NODE_HPP
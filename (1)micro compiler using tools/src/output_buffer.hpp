@@ -0,0 +1,113 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 19th, 2026
+ *
+ * This file defines the OutputBuffer class, the output layer shared by the IR generator and the .dot exporter.
+ * Text is appended into large chunks and written out in big blocks through writev, instead of one flush per line.
+ */
+
+#ifndef CSC4180_OUTPUT_BUFFER_HPP
+#define CSC4180_OUTPUT_BUFFER_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Append-only output buffer
+ *
+ * Two modes are supported:
+ *   - file mode: constructed with a filename, full chunks are written through a single writev
+ *     whenever FLUSH_CHUNKS chunks are pending, and the rest on flush()/close()/destruction
+ *   - memory mode: default constructed, the whole content is kept in memory and can be read with str()
+ */
+class OutputBuffer {
+public:
+    static const size_t CHUNK_SIZE = 64 * 1024;     // bytes per chunk
+    static const size_t FLUSH_CHUNKS = 16;          // pending chunks per writev in file mode
+
+    /**
+     * Memory mode: keep the whole output in memory for in-process consumers
+     */
+    OutputBuffer();
+
+    /**
+     * File mode: the file is created (or truncated) immediately
+     * @param filename: file to write to, "-" for stdout
+     */
+    explicit OutputBuffer(const std::string &filename);
+
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    ~OutputBuffer();
+
+    /**
+     * @return true if the buffer is backed by an open file
+     */
+    bool is_open() const { return fd >= 0; }
+
+    /**
+     * Append raw bytes to the buffer
+     * @param data
+     * @param len
+     * @return
+     */
+    void write(const char *data, size_t len);
+
+    /**
+     * Append the decimal form of an integer without going through iostream or printf
+     * @param value
+     * @return
+     */
+    void write_int(long long value);
+
+    OutputBuffer &operator<<(const std::string &s) { write(s.data(), s.size()); return *this; }
+    OutputBuffer &operator<<(std::string_view s) { write(s.data(), s.size()); return *this; }
+    OutputBuffer &operator<<(const char *s);
+    OutputBuffer &operator<<(char c);
+    OutputBuffer &operator<<(int value) { write_int(value); return *this; }
+    OutputBuffer &operator<<(long value) { write_int(value); return *this; }
+    OutputBuffer &operator<<(long long value) { write_int(value); return *this; }
+    OutputBuffer &operator<<(unsigned value) { write_int(value); return *this; }
+    OutputBuffer &operator<<(unsigned long value) { write_int((long long)value); return *this; }
+
+    /**
+     * Write all pending chunks to the file (no-op in memory mode)
+     * @return
+     */
+    void flush();
+
+    /**
+     * Flush and close the file, later writes are kept in memory
+     * @return
+     */
+    void close();
+
+    /**
+     * @return the buffered content (the whole output in memory mode, the unflushed tail in file mode)
+     */
+    std::string str() const;
+
+    /**
+     * @return total number of bytes appended so far
+     */
+    size_t size() const { return total_bytes; }
+
+private:
+    void new_chunk();
+
+private:
+    int fd;                         // -1 in memory mode
+    bool owns_fd;                   // false for stdout
+    std::vector<char *> chunks;     // every chunk holds CHUNK_SIZE bytes
+    size_t pos;                     // bytes used in the last chunk
+    size_t total_bytes;
+};
+
+#endif  // CSC4180_OUTPUT_BUFFER_HPP
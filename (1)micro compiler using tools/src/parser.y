@@ -12,6 +12,17 @@
  * in File: added_structure_function.c
  */
 
+%code requires {
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+#include "node.hpp"
+
+struct ParserContext;
+}
+
 %{
 /* C declarations used in actions */
 #include <cstdio>     
@@ -22,23 +33,31 @@
 #include <ctype.h>
 
 #include "node.hpp"
+#include "compiler.hpp"
 
-int yyerror (char *s);
-
-int yylex();
-
-extern int cst_only;
-
-Node* root_node = nullptr;
+// the parser stacks are on the heap and double when full, let deeply nested expressions grow them
+// far beyond bison's default of 10000 levels
+#define YYMAXDEPTH 100000000
 %}
 
+// Pure parser: the scanner handle and the context of the current compilation replace the former globals
+%define api.pure full
+%param {yyscan_t scanner}
+%parse-param {ParserContext* context}
+
 // Define yylval data types with %union
 %union {
 	int intval;
-	const char* strval;
+	Lexeme strval;
 	struct Node* nodeval;
 }
 
+%{
+int yylex(YYSTYPE* yylval, yyscan_t scanner);
+
+int yyerror(yyscan_t scanner, ParserContext* context, const char* s);
+%}
+
 
 // Define terminal symbols with %token. Remember to set the type.
 %token <intval> TOK_INTLITERAL
@@ -63,94 +82,94 @@ Node* root_node = nullptr;
 // Production rule here
 // The tree generation logic should be in the operation block of each production rule
 start   : program TOK_SCANEOF {
-			if (cst_only == 1){
+			if (context->cst_only == 1){
 				// cst
-				root_node = new Node(SymbolClass::START);
-				root_node->append_child($1);
-				root_node->append_child(new Node(SymbolClass::SCANEOF));
+				context->root_node = context->arena.make<Node>(SymbolClass::START);
+				context->root_node->append_child(context->arena, $1);
+				context->root_node->append_child(context->arena, context->arena.make<Node>(SymbolClass::SCANEOF));
 			} else {
 				// ast
-				root_node = $1;
+				context->root_node = $1;
 			}
 			
 			return 0;
 		};
 
 program : TOK_BEGIN statement_list TOK_END {
-			$$ = new Node(SymbolClass::PROGRAM);
-			if (cst_only == 1){
+			$$ = context->arena.make<Node>(SymbolClass::PROGRAM);
+			if (context->cst_only == 1){
 				// cst
-				$$->append_child(new Node(SymbolClass::BEGIN_));
-				$$->append_child($2);
-				$$->append_child(new Node(SymbolClass::END));
+				$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::BEGIN_));
+				$$->append_child(context->arena, $2);
+				$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::END));
 			} else {
 				// ast
-				$$->append_child($2);
+				$$->append_child(context->arena, $2);
 			}
 		};
 
 statement_list  : statement {
-					$$ = new Node(SymbolClass::STATEMENT_LIST);
-					$$ ->append_child($1);
+					$$ = context->arena.make<Node>(SymbolClass::STATEMENT_LIST);
+					$$ ->append_child(context->arena, $1);
 				}
 				| statement_list statement  {
-					if (cst_only == 1){
+					if (context->cst_only == 1){
 						// cst
-						$$ = new Node(SymbolClass::STATEMENT_LIST);
-						$$->append_child($1);
-						$$->append_child($2);
+						$$ = context->arena.make<Node>(SymbolClass::STATEMENT_LIST);
+						$$->append_child(context->arena, $1);
+						$$->append_child(context->arena, $2);
 					} else {
 						// ast
-						$1->append_child($2);
+						$1->append_child(context->arena, $2);
 						$$ = $1;
 					}
 				};
 
 statement   : TOK_ID TOK_ASSIGNOP expression TOK_SEMICOLON {
-				if (cst_only == 1) {
+				if (context->cst_only == 1) {
 					// cst
-					$$ = new Node(SymbolClass::STATEMENT);
-					$$->append_child(new Node(SymbolClass::ID));
-					$$->append_child(new Node(SymbolClass::ASSIGNOP));
-					$$->append_child($3);
-					$$->append_child(new Node(SymbolClass::SEMICOLON));
+					$$ = context->arena.make<Node>(SymbolClass::STATEMENT);
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::ID));
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::ASSIGNOP));
+					$$->append_child(context->arena, $3);
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::SEMICOLON));
 				} else {
 					// ast
-					$$ = new Node(SymbolClass::ASSIGNOP,$2);
-					$$->append_child(new Node(SymbolClass::ID,$1));
-					$$->append_child($3);
+					$$ = context->arena.make<Node>(SymbolClass::ASSIGNOP,$2);
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::ID,$1));
+					$$->append_child(context->arena, $3);
 				}
 			}
 			| TOK_READ TOK_LPAREN id_list TOK_RPAREN TOK_SEMICOLON {
-				if (cst_only == 1){
+				if (context->cst_only == 1){
 					// cst
-					$$ = new Node(SymbolClass::STATEMENT);
-					$$->append_child(new Node(SymbolClass::READ));
-					$$->append_child(new Node(SymbolClass::LPAREN));
-					$$->append_child($3);
-					$$->append_child(new Node(SymbolClass::RPAREN));
-					$$->append_child(new Node(SymbolClass::SEMICOLON));
+					$$ = context->arena.make<Node>(SymbolClass::STATEMENT);
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::READ));
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::LPAREN));
+					$$->append_child(context->arena, $3);
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::RPAREN));
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::SEMICOLON));
 				} else {
 					// ast
-					$$ = new Node(SymbolClass::READ, $1);
+					$$ = context->arena.make<Node>(SymbolClass::READ, $1);
 					$$->children = $3->children;
 				}
 			}
 			| TOK_WRITE TOK_LPAREN expression_list TOK_RPAREN TOK_SEMICOLON {
-				if (cst_only == 1){
+				if (context->cst_only == 1){
 					// cst
-					$$ = new Node(SymbolClass::STATEMENT);
-					$$->append_child(new Node(SymbolClass::WRITE));
-					$$->append_child(new Node(SymbolClass::LPAREN));
-					$$->append_child($3);
-					$$->append_child(new Node(SymbolClass::RPAREN));
-					$$->append_child(new Node(SymbolClass::SEMICOLON));
+					$$ = context->arena.make<Node>(SymbolClass::STATEMENT);
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::WRITE));
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::LPAREN));
+					$$->append_child(context->arena, $3);
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::RPAREN));
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::SEMICOLON));
 				} else {
 					// ast
 					// different situation
-					$$ = new Node(SymbolClass::WRITE, $1);
+					$$ = context->arena.make<Node>(SymbolClass::WRITE, $1);
 					if ($3->children.empty() || $3->should_preserver_in_ast()) {
-						$$->append_child($3);
+						$$->append_child(context->arena, $3);
 					} else {
 						$$->children = $3->children;
 					}
@@ -158,62 +177,57 @@ statement   : TOK_ID TOK_ASSIGNOP expression TOK_SEMICOLON {
 			};
 
 id_list : TOK_ID {
-			$$ = new Node(SymbolClass::ID_LIST);
-			if (cst_only == 1){
+			$$ = context->arena.make<Node>(SymbolClass::ID_LIST);
+			if (context->cst_only == 1){
 				// cst
-				$$->append_child(new Node(SymbolClass::ID));
+				$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::ID));
 			} else {
 				// ast
-				$$->append_child(new Node(SymbolClass::ID, $1));
+				$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::ID, $1));
 			}
 		}
 		| id_list TOK_COMMA TOK_ID {
-			$$ = new Node(SymbolClass::ID_LIST);
-			if (cst_only == 1){
+			if (context->cst_only == 1){
 				// cst
-				$$->append_child(new Node(SymbolClass::ID));
-				$$->append_child(new Node(SymbolClass::COMMA));
-				$$->append_child($1);
+				$$ = context->arena.make<Node>(SymbolClass::ID_LIST);
+				$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::ID));
+				$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::COMMA));
+				$$->append_child(context->arena, $1);
 			} else {
 				// ast
-				// different situation
-				if ($1->children.empty()){
-					$$ = new Node(SymbolClass::ID_LIST);
-					$$->append_child($1);
-					$$->append_child(new Node(SymbolClass::ID, $3));
-				} else {
-					$$->children = $1->children;
-					$$->append_child(new Node(SymbolClass::ID, $3));
-				}
+				// the id list stays flat, append to it in place
+				$1->append_child(context->arena, context->arena.make<Node>(SymbolClass::ID, $3));
+				$$ = $1;
 			}
 		};
 
 expression_list : expression {
-					if (cst_only == 1){
+					if (context->cst_only == 1){
 						// cst
-						$$ = new Node(SymbolClass::EXPRESSION_LIST);
-						$$->append_child($1);
+						$$ = context->arena.make<Node>(SymbolClass::EXPRESSION_LIST);
+						$$->append_child(context->arena, $1);
 					} else {
 						// ast
 						$$ = $1;
 					}
 				}
 				| expression_list TOK_COMMA expression {
-					if (cst_only == 1){
+					if (context->cst_only == 1){
 						// cst
-						$$ = new Node(SymbolClass::COMMA);
-						$$->append_child($1);
-						$$->append_child(new Node(SymbolClass::COMMA));
-						$$->append_child($3);
+						$$ = context->arena.make<Node>(SymbolClass::COMMA);
+						$$->append_child(context->arena, $1);
+						$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::COMMA));
+						$$->append_child(context->arena, $3);
 					} else {
 						// ast
 						// different situation
-						if ($1->children.empty()){
-							$$ = new Node(SymbolClass::EXPRESSION_LIST);
-							$$->append_child($1);
-							$$->append_child($3);
+						// the first expression may itself have children (a+b), so check the symbol class
+						if ($1->symbol_class != SymbolClass::EXPRESSION_LIST){
+							$$ = context->arena.make<Node>(SymbolClass::EXPRESSION_LIST);
+							$$->append_child(context->arena, $1);
+							$$->append_child(context->arena, $3);
 						} else {
-							$1->append_child($3);
+							$1->append_child(context->arena, $3);
 							$$ = $1;
 						}
 					}
@@ -221,78 +235,78 @@ expression_list : expression {
 
 
 expression  : primary {
-				if (cst_only == 1){
+				if (context->cst_only == 1){
 					// cst
-					$$ = new Node(SymbolClass::EXPRESSION);
-					$$->append_child($1);
+					$$ = context->arena.make<Node>(SymbolClass::EXPRESSION);
+					$$->append_child(context->arena, $1);
 				} else {
 					// ast
 					$$ = $1;
 				}
 			}
 			| expression TOK_PLUSOP primary {
-				if (cst_only == 1){
+				if (context->cst_only == 1){
 					// cst
-					$$ = new Node(SymbolClass::EXPRESSION);
-					$$->append_child($1);
-					$$->append_child(new Node(SymbolClass::PLUSOP));
-					$$->append_child($3);
+					$$ = context->arena.make<Node>(SymbolClass::EXPRESSION);
+					$$->append_child(context->arena, $1);
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::PLUSOP));
+					$$->append_child(context->arena, $3);
 				} else {
 					// ast
-					$$ = new Node(SymbolClass::PLUSOP, $2);
-					$$->append_child($1);
-					$$->append_child($3);
+					$$ = context->arena.make<Node>(SymbolClass::PLUSOP, $2);
+					$$->append_child(context->arena, $1);
+					$$->append_child(context->arena, $3);
 				}
 			}
 			| expression TOK_MINUSOP primary {
-				if (cst_only == 1){
+				if (context->cst_only == 1){
 					// cst
-					$$ = new Node(SymbolClass::EXPRESSION);
-					$$->append_child($1);
-					$$->append_child(new Node(SymbolClass::MINUSOP));
-					$$->append_child($3);
+					$$ = context->arena.make<Node>(SymbolClass::EXPRESSION);
+					$$->append_child(context->arena, $1);
+					$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::MINUSOP));
+					$$->append_child(context->arena, $3);
 				} else {
 					// ast
-					$$ = new Node(SymbolClass::MINUSOP, $2);
-					$$->append_child($1);
-					$$->append_child($3);
+					$$ = context->arena.make<Node>(SymbolClass::MINUSOP, $2);
+					$$->append_child(context->arena, $1);
+					$$->append_child(context->arena, $3);
 				}				
 			};
 
 primary : TOK_LPAREN expression TOK_RPAREN {
-			if (cst_only == 1){
+			if (context->cst_only == 1){
 				// cst
-				$$ = new Node(SymbolClass::PRIMARY);
-				$$->append_child(new Node(SymbolClass::LPAREN));
-				$$->append_child($2);
-				$$->append_child(new Node(SymbolClass::RPAREN));
+				$$ = context->arena.make<Node>(SymbolClass::PRIMARY);
+				$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::LPAREN));
+				$$->append_child(context->arena, $2);
+				$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::RPAREN));
 			} else {
 				//ast
 				$$ = $2;
 			}
 		}
 		| TOK_ID {
-			if (cst_only == 1) {
-				$$ = new Node(SymbolClass::PRIMARY);
-				$$->append_child(new Node(SymbolClass::ID));
+			if (context->cst_only == 1) {
+				$$ = context->arena.make<Node>(SymbolClass::PRIMARY);
+				$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::ID));
 			} else {
-				$$ = new Node(SymbolClass::ID, $1);
+				$$ = context->arena.make<Node>(SymbolClass::ID, $1);
 			}
 		}
 		| TOK_INTLITERAL {
-			if (cst_only == 1){
+			if (context->cst_only == 1){
 				// cst
-				$$ = new Node(SymbolClass::PRIMARY);
-				$$->append_child(new Node(SymbolClass::INTLITERAL));
+				$$ = context->arena.make<Node>(SymbolClass::PRIMARY);
+				$$->append_child(context->arena, context->arena.make<Node>(SymbolClass::INTLITERAL));
 			} else {
-				$$ = new Node(SymbolClass::INTLITERAL, std::to_string($1));
+				$$ = context->arena.make<Node>(SymbolClass::INTLITERAL, context->arena.copy(std::to_string($1)));
 
 			}
 		};
 
 %%
 
-int yyerror(char *s) {
-	printf("Syntax Error on line %s\n", s);
+int yyerror(yyscan_t /* scanner */, ParserContext* context, const char* s) {
+	context->errors += "Syntax Error on line " + std::string(s) + "\n";
 	return 0;
 }
@@ -0,0 +1,440 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 19th, 2026
+ *
+ * This file implements the RISC-V Generator class defined in riscv_generator.hpp
+ *
+ * Stack frame of main (from sp upwards):
+ *   [outgoing printf/scanf arguments beyond a7] [read scratch slots] [spill slots] [saved s-registers, ra]
+ */
+
+#include "riscv_generator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Callee-saved registers keep variables alive across scanf/printf calls
+static const char* SAVED_REGISTERS[] = {"s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11"};
+static const int NUM_SAVED_REGISTERS = 12;
+// t0-t4 form the expression stack, t5/t6 hold addresses and operands popped from the stack
+static const char* TEMP_REGISTERS[] = {"t0", "t1", "t2", "t3", "t4"};
+static const int NUM_TEMP_REGISTERS = 5;
+// a0 holds the format string, a1-a7 the first 7 values, the rest go on the stack
+static const int NUM_ARG_REGISTERS = 7;
+
+static bool fits_imm12(long value) {
+    return value >= -2048 && value <= 2047;
+}
+
+void RISCV_Generator::export_ast_to_riscv_asm(Node* node) {
+    export_ast_to_riscv_asm(FlatAst(node));
+}
+
+void RISCV_Generator::export_ast_to_riscv_asm(const FlatAst& ast) {
+    if (ast.empty()) {
+        std::cerr << "Error: the ast is empty!" << std::endl;
+        return;
+    }
+    this->ast = &ast;
+    collect_statements(ast.root());
+    zero_inits.resize(statements.size());
+    for (int i = 0; i < (int)statements.size(); ++i) {
+        NodeRef statement = statements[i];
+        switch (statement.symbol_class()) {
+            case SymbolClass::ASSIGNOP:
+                // uses on the right-hand side come before the definition
+                scan_variables(statement.child(1), i, false);
+                scan_variables(statement.child(0), i, true);
+                break;
+            case SymbolClass::READ:
+                scan_variables(statement, i, true);
+                max_read_count = std::max(max_read_count, (int)statement.child_count());
+                max_stack_args = std::max(max_stack_args, (int)statement.child_count() - NUM_ARG_REGISTERS);
+                break;
+            case SymbolClass::WRITE:
+                scan_variables(statement, i, false);
+                max_stack_args = std::max(max_stack_args, (int)statement.child_count() - NUM_ARG_REGISTERS);
+                break;
+            default:
+                break;
+        }
+    }
+    allocate_registers();
+
+    long saved_bytes = 8 * (long)(used_saved_registers.size() + 1);
+    frame_size = 8L * (max_stack_args + max_read_count + spill_count) + saved_bytes;
+    frame_size = (frame_size + 15) / 16 * 16;
+
+    out << "\t.text\n";
+    out << "\t.globl\tmain\n";
+    out << "\t.type\tmain, @function\n";
+    out << "main:\n";
+    // prologue
+    if (fits_imm12(-frame_size)) {
+        out << "\taddi\tsp, sp, -" << frame_size << "\n";
+    } else {
+        out << "\tli\tt5, " << frame_size << "\n";
+        out << "\tsub\tsp, sp, t5\n";
+    }
+    long save_offset = frame_size - 8;
+    emit_sp_access("sd", "ra", save_offset);
+    for (auto &reg : used_saved_registers) {
+        save_offset -= 8;
+        emit_sp_access("sd", reg, save_offset);
+    }
+
+    for (int i = 0; i < (int)statements.size(); ++i) {
+        // Micro variables start as 0 when they are read before any assignment
+        for (auto var : zero_inits[i]) {
+            if (var->reg.empty())
+                emit_sp_access("sw", "zero", spill_offset(*var));
+            else
+                out << "\tli\t" << var->reg << ", 0\n";
+        }
+        gen_statement(statements[i]);
+    }
+
+    // epilogue
+    out << "\tli\ta0, 0\n";
+    save_offset = frame_size - 8;
+    emit_sp_access("ld", "ra", save_offset);
+    for (auto &reg : used_saved_registers) {
+        save_offset -= 8;
+        emit_sp_access("ld", reg, save_offset);
+    }
+    if (fits_imm12(frame_size)) {
+        out << "\taddi\tsp, sp, " << frame_size << "\n";
+    } else {
+        out << "\tli\tt5, " << frame_size << "\n";
+        out << "\tadd\tsp, sp, t5\n";
+    }
+    out << "\tret\n";
+    out << "\t.size\tmain, .-main\n";
+
+    // format strings of scanf and printf
+    out << "\n\t.section\t.rodata\n";
+    for (auto &format : format_labels) {
+        out << format.second << ":\n";
+        out << "\t.string\t\"" << format.first << "\"\n";
+    }
+    out.close();
+}
+
+void RISCV_Generator::collect_statements(NodeRef node) {
+    // forward scan in pre-order, which is program order; a statement's subtree is skipped
+    uint32_t index = node.index();
+    while (index < node.subtree_end()) {
+        switch (ast->symbol_class[index]) {
+            case SymbolClass::ASSIGNOP:
+            case SymbolClass::READ:
+            case SymbolClass::WRITE:
+                statements.push_back(ast->node(index));
+                index = ast->subtree_end[index];
+                break;
+            default:
+                ++index;
+                break;
+        }
+    }
+}
+
+void RISCV_Generator::scan_variables(NodeRef node, int statement_idx, bool is_def) {
+    for (uint32_t index = node.index(); index < node.subtree_end(); ++index) {
+        if (ast->symbol_class[index] == SymbolClass::ID) {
+            Variable &var = variables[ast->lexeme(index)];
+            if (var.first == -1) {
+                var.first = statement_idx;
+                if (!is_def) {
+                    var.used_before_def = true;
+                    zero_inits[statement_idx].push_back(&var);
+                }
+            }
+            var.last = statement_idx;
+        }
+    }
+}
+
+/*
+ * Linear scan (Poletto & Sarkar): walk intervals by increasing start, expire the ones that ended,
+ * and when no register is free spill whichever interval ends last.
+ */
+void RISCV_Generator::allocate_registers() {
+    std::vector<Variable*> intervals;
+    for (auto &item : variables) {
+        intervals.push_back(&item.second);
+    }
+    std::stable_sort(intervals.begin(), intervals.end(),
+        [](const Variable* a, const Variable* b) { return a->first < b->first; });
+
+    std::vector<std::string> free_registers;
+    for (int i = NUM_SAVED_REGISTERS - 1; i >= 0; --i) {
+        free_registers.push_back(SAVED_REGISTERS[i]);
+    }
+    std::vector<bool> register_used(NUM_SAVED_REGISTERS, false);
+    std::vector<Variable*> active;     // sorted by increasing end
+
+    auto insert_active = [&active](Variable* var) {
+        auto pos = std::upper_bound(active.begin(), active.end(), var,
+            [](const Variable* a, const Variable* b) { return a->last < b->last; });
+        active.insert(pos, var);
+    };
+    auto mark_used = [&register_used](const std::string &reg) {
+        for (int i = 0; i < NUM_SAVED_REGISTERS; ++i)
+            if (reg == SAVED_REGISTERS[i]) register_used[i] = true;
+    };
+
+    for (auto var : intervals) {
+        // expire old intervals
+        size_t expired = 0;
+        while (expired < active.size() && active[expired]->last < var->first) {
+            free_registers.push_back(active[expired]->reg);
+            ++expired;
+        }
+        active.erase(active.begin(), active.begin() + expired);
+
+        if (free_registers.empty()) {
+            Variable* spill = active.back();
+            if (spill->last > var->last) {
+                var->reg = spill->reg;
+                spill->reg = "";
+                spill->slot = spill_count++;
+                active.pop_back();
+                insert_active(var);
+            } else {
+                var->slot = spill_count++;
+            }
+        } else {
+            var->reg = free_registers.back();
+            free_registers.pop_back();
+            mark_used(var->reg);
+            insert_active(var);
+        }
+    }
+    for (int i = 0; i < NUM_SAVED_REGISTERS; ++i) {
+        if (register_used[i]) used_saved_registers.push_back(SAVED_REGISTERS[i]);
+    }
+}
+
+void RISCV_Generator::gen_statement(NodeRef node) {
+    switch (node.symbol_class()) {
+        case SymbolClass::ASSIGNOP:
+            gen_assignop_riscv_asm(node);
+            break;
+        case SymbolClass::READ:
+            gen_read_riscv_asm(node);
+            break;
+        case SymbolClass::WRITE:
+            gen_write_riscv_asm(node);
+            break;
+        default:
+            std::cerr << "Invalid statement!" << std::endl;
+            break;
+    }
+}
+
+/*
+ * ":=" operation, the left varible is children[0], the right value is children[1]
+ */
+void RISCV_Generator::gen_assignop_riscv_asm(NodeRef node) {
+    Variable &var = variables[node.child(0).lexeme()];
+    std::string value = gen_expression(node.child(1), 0, var.reg);
+    if (var.reg.empty()) {
+        emit_sp_access("sw", value, spill_offset(var));
+    } else if (value != var.reg) {
+        out << "\tmv\t" << var.reg << ", " << value << "\n";
+    }
+}
+
+/*
+ * la   a0, <"%d ... %d">
+ * addi a1, sp, <slot of 1st variable>
+ * ...
+ * call scanf
+ * lw   <register of 1st variable>, <slot>(sp)
+ */
+void RISCV_Generator::gen_read_riscv_asm(NodeRef node) {
+    std::string format_info = "";
+    size_t count = node.child_count();
+    for (size_t i = 0; i < count; ++i) {
+        format_info += (i == 0) ? "%d" : " %d";
+    }
+    long scratch_base = 8L * max_stack_args;
+    size_t i = 0;
+    for (NodeRef child : node.children()) {
+        Variable &var = variables[child.lexeme()];
+        // spilled variables are read in place, the others through a scratch slot
+        long offset = var.reg.empty() ? spill_offset(var) : scratch_base + 8L * i;
+        std::string target = (i < NUM_ARG_REGISTERS) ? "a" + std::to_string(i + 1) : "t5";
+        if (fits_imm12(offset)) {
+            out << "\taddi\t" << target << ", sp, " << offset << "\n";
+        } else {
+            out << "\tli\t" << target << ", " << offset << "\n";
+            out << "\tadd\t" << target << ", " << target << ", sp\n";
+        }
+        if (i >= NUM_ARG_REGISTERS) emit_sp_access("sd", "t5", 8L * (i - NUM_ARG_REGISTERS));
+        ++i;
+    }
+    out << "\tla\ta0, " << format_label(format_info) << "\n";
+    out << "\tcall\tscanf\n";
+    i = 0;
+    for (NodeRef child : node.children()) {
+        Variable &var = variables[child.lexeme()];
+        if (!var.reg.empty()) emit_sp_access("lw", var.reg, scratch_base + 8L * i);
+        ++i;
+    }
+}
+
+/*
+ * <evaluate each expression into a1, a2, ... or its stack argument slot>
+ * la   a0, <"%d ... %d\n">
+ * call printf
+ */
+void RISCV_Generator::gen_write_riscv_asm(NodeRef node) {
+    std::string format_info = "";
+    size_t count = node.child_count();
+    for (size_t i = 0; i < count; ++i) {
+        format_info += (i == 0) ? "%d" : " %d";
+    }
+    format_info += "\\n";
+    // expressions only use t- and s-registers, so the a-registers filled so far stay intact
+    size_t i = 0;
+    for (NodeRef child : node.children()) {
+        if (i < NUM_ARG_REGISTERS) {
+            std::string arg = "a" + std::to_string(i + 1);
+            std::string value = gen_expression(child, 0, arg);
+            if (value != arg) out << "\tmv\t" << arg << ", " << value << "\n";
+        } else {
+            emit_sp_access("sd", gen_expression(child, 0), 8L * (i - NUM_ARG_REGISTERS));
+        }
+        ++i;
+    }
+    out << "\tla\ta0, " << format_label(format_info) << "\n";
+    out << "\tcall\tprintf\n";
+}
+
+std::string RISCV_Generator::gen_expression(NodeRef node, int depth, const std::string &dest) {
+    /*
+     * Post-order walk with an explicit stack of frames, one per operator being evaluated, so that
+     * arbitrarily deep expressions use no call stack. `result` is the register of the operand finished last.
+     */
+    enum Stage { START, LEFT_DONE, RIGHT_DONE };
+    struct Frame {
+        NodeRef node;
+        int depth;
+        std::string target;
+        Stage stage;
+        std::string lvalue;
+        bool pushed;            // the left operand was pushed on the stack while evaluating the right one
+    };
+    std::vector<Frame> stack;
+    std::string result;
+    stack.push_back({node, depth, dest.empty() ? TEMP_REGISTERS[depth] : dest, START, "", false});
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        NodeRef current = frame.node;
+        bool is_add = current.symbol_class() == SymbolClass::PLUSOP;
+        switch (frame.stage) {
+            case START:
+                switch (current.symbol_class()) {
+                    case SymbolClass::ID: {
+                        Variable &var = variables[current.lexeme()];
+                        if (!var.reg.empty()) {
+                            result = var.reg;
+                        } else {
+                            emit_sp_access("lw", frame.target, spill_offset(var));
+                            result = frame.target;
+                        }
+                        stack.pop_back();
+                        break;
+                    }
+                    case SymbolClass::INTLITERAL:
+                        out << "\tli\t" << frame.target << ", " << current.lexeme() << "\n";
+                        result = frame.target;
+                        stack.pop_back();
+                        break;
+                    case SymbolClass::PLUSOP:
+                    case SymbolClass::MINUSOP: {
+                        frame.stage = LEFT_DONE;
+                        int left_depth = frame.depth;
+                        stack.push_back({current.child(0), left_depth, TEMP_REGISTERS[left_depth], START, "", false});
+                        break;
+                    }
+                    default:
+                        std::cerr << "Error oprand!" << std::endl;
+                        result = "zero";
+                        stack.pop_back();
+                        break;
+                }
+                break;
+            case LEFT_DONE: {
+                frame.lvalue = result;
+                NodeRef right_child = current.child(1);
+                // x + imm, x - imm
+                if (right_child.symbol_class() == SymbolClass::INTLITERAL) {
+                    long imm = right_child.int_value();
+                    if (!is_add) imm = -imm;
+                    if (fits_imm12(imm)) {
+                        out << "\taddiw\t" << frame.target << ", " << frame.lvalue << ", " << imm << "\n";
+                        result = frame.target;
+                        stack.pop_back();
+                        break;
+                    }
+                }
+                frame.stage = RIGHT_DONE;
+                int right_depth = frame.depth;
+                if (frame.depth + 1 < NUM_TEMP_REGISTERS) {
+                    ++right_depth;
+                } else {
+                    // out of temporaries: keep the left operand on the stack while evaluating the right one
+                    frame.pushed = frame.lvalue[0] == 't';
+                    if (frame.pushed) {
+                        out << "\taddi\tsp, sp, -16\n";
+                        out << "\tsd\t" << frame.lvalue << ", 0(sp)\n";
+                        sp_adjust += 16;
+                    }
+                }
+                stack.push_back({right_child, right_depth, TEMP_REGISTERS[right_depth], START, "", false});
+                break;
+            }
+            case RIGHT_DONE:
+                if (frame.pushed) {
+                    out << "\tld\tt6, 0(sp)\n";
+                    out << "\taddi\tsp, sp, 16\n";
+                    sp_adjust -= 16;
+                    frame.lvalue = "t6";
+                }
+                out << "\t" << (is_add ? "addw" : "subw") << "\t" << frame.target << ", " << frame.lvalue << ", " << result << "\n";
+                result = frame.target;
+                stack.pop_back();
+                break;
+        }
+    }
+    return result;
+}
+
+void RISCV_Generator::emit_sp_access(const char* op, const std::string &reg, long offset) {
+    offset += sp_adjust;
+    if (fits_imm12(offset)) {
+        out << "\t" << op << "\t" << reg << ", " << offset << "(sp)\n";
+    } else {
+        out << "\tli\tt6, " << offset << "\n";
+        out << "\tadd\tt6, t6, sp\n";
+        out << "\t" << op << "\t" << reg << ", 0(t6)\n";
+    }
+}
+
+std::string RISCV_Generator::format_label(const std::string &format) {
+    auto it = format_labels.find(format);
+    if (it != format_labels.end()) return it->second;
+    std::string label = ".LC" + std::to_string(format_labels.size());
+    format_labels[format] = label;
+    return label;
+}
+
+long RISCV_Generator::spill_offset(const Variable &var) const {
+    return 8L * (max_stack_args + max_read_count + var.slot);
+}
@@ -0,0 +1,123 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 19th, 2026
+ *
+ * This file defines the RISC-V Generator class, which generates RISC-V 64 assembly (.s) directly from the AST,
+ * bypassing the LLVM opt/llc round trip.
+ */
+
+#ifndef CSC4180_RISCV_GENERATOR_HPP
+#define CSC4180_RISCV_GENERATOR_HPP
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flat_ast.hpp"
+#include "node.hpp"
+#include "output_buffer.hpp"
+
+/**
+ * RISC-V 64 Generator of Micro Language
+ *
+ * Micro programs are straight-line code, so the live interval of a variable is exactly
+ * [first statement using it, last statement using it]. Variables are assigned to the callee-saved
+ * registers s0-s11 by linear scan over these intervals (they survive the scanf/printf calls),
+ * and the ones that do not fit are spilled to stack slots.
+ * Expressions are evaluated on a stack of temporary registers t0-t4.
+ */
+class RISCV_Generator {
+public:
+    RISCV_Generator(OutputBuffer &output)
+        : out(output) {}
+
+    /**
+     * Export AST to RISC-V 64 assembly
+     *
+     * It collects the statements, allocates registers, then generates the main function
+     *
+     * @param ast: the flattened AST
+     * @return
+     */
+    void export_ast_to_riscv_asm(const FlatAst& ast);
+
+    /**
+     * Same as above for a Node tree, which is flattened first
+     * @param node: root of the AST
+     * @return
+     */
+    void export_ast_to_riscv_asm(Node* node);
+
+private:
+    /**
+     * Location of a Micro variable, either a register or a stack slot
+     */
+    struct Variable {
+        int first = -1;             // index of the first statement using the variable
+        int last = -1;              // index of the last statement using the variable
+        bool used_before_def = false;
+        std::string reg;            // allocated register, empty if spilled
+        int slot = -1;              // spill slot index, -1 if in register
+    };
+
+    /**
+     * Collect statements (ASSIGNOP, READ, WRITE) in program order
+     */
+    void collect_statements(NodeRef node);
+
+    /**
+     * Record the uses and definitions of variables in one statement
+     */
+    void scan_variables(NodeRef node, int statement_idx, bool is_def);
+
+    /**
+     * Linear scan register allocation over the live intervals of variables
+     */
+    void allocate_registers();
+
+    void gen_statement(NodeRef node);
+
+    void gen_assignop_riscv_asm(NodeRef node);
+
+    void gen_read_riscv_asm(NodeRef node);
+
+    void gen_write_riscv_asm(NodeRef node);
+
+    /**
+     * Evaluate an expression, using temporary registers from the given depth
+     * The expression tree is walked with an explicit stack, its depth is not bounded by the call stack
+     * @param dest: register for the result of this node if not empty, operands still use temporaries
+     * @return the register holding the result (a variable register is returned as is)
+     */
+    std::string gen_expression(NodeRef node, int depth, const std::string &dest = "");
+
+    /**
+     * Emit load/store with an sp-relative offset, handling offsets outside the 12-bit immediate range
+     */
+    void emit_sp_access(const char* op, const std::string &reg, long offset);
+
+    std::string format_label(const std::string &format);
+
+    long spill_offset(const Variable &var) const;
+
+private:
+    OutputBuffer &out;
+    const FlatAst* ast = nullptr;                       // the tree being exported
+    std::vector<NodeRef> statements;
+    std::map<std::string_view, Variable> variables;  // keyed by lexemes viewing the source
+    std::vector<std::vector<Variable*>> zero_inits;     // variables read before written, per statement
+    std::vector<std::string> used_saved_registers;
+    std::map<std::string, std::string> format_labels;   // format string -> .rodata label
+    int spill_count = 0;
+    int max_read_count = 0;
+    int max_stack_args = 0;
+    long frame_size = 0;
+    long sp_adjust = 0;     // bytes temporarily pushed while evaluating deep expressions
+};
+
+#endif  // CSC4180_RISCV_GENERATOR_HPP
@@ -0,0 +1,26 @@
+#!/bin/bash
+make all
+
+cd ../testcases
+mkdir -p ./riscv_assembly
+mkdir -p ./executable
+mkdir -p ./input
+mkdir -p ./output
+
+for test_idx in {0..9}; do
+    test="test$test_idx"
+    test_program="./test$test_idx.m"
+    echo "$test"
+    # RISC-V assembly straight from the AST, no opt/llc round trip
+    ../src/compiler -S ./riscv_assembly/${test}-native.s $test_program > /dev/null
+    # to executable
+    riscv64-unknown-linux-gnu-gcc ./riscv_assembly/${test}-native.s -o ./executable/${test}-native
+    # verify the execution results
+    qemu-riscv64 -L /opt/riscv/sysroot ./executable/${test}-native < ./input/${test}.txt > ./output/${test}-native.txt
+    if diff -q ./output/${test}-native.txt ./output/${test}-expected.txt; then
+        echo "|--Pass"
+    else
+        echo "|--Failed"
+        diff ./output/${test}-native.txt ./output/${test}-expected.txt
+    fi
+done
@@ -0,0 +1,145 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 23rd, 2026
+ *
+ * This file implements the measurements defined in stats.hpp, and counts the allocations of every thread
+ * by replacing the global operator new.
+ */
+
+#include "stats.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <sys/resource.h>
+#include <time.h>
+
+static thread_local uint64_t allocation_count = 0;
+static thread_local uint64_t allocation_bytes = 0;
+
+/*
+ * Counting is two thread-local increments, cheap enough to stay on without --stats.
+ * operator new[] and the nothrow versions end up here too.
+ */
+void* operator new(std::size_t size) {
+    ++allocation_count;
+    allocation_bytes += size;
+    if (size == 0) size = 1;
+    for (;;) {
+        void* p = std::malloc(size);
+        if (p != nullptr) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static double clock_ms(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static long peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+PhaseTimer::PhaseTimer(Stats* stats, const char* name)
+    : stats(stats), name(name) {
+    if (stats == nullptr) return;
+    wall_start = clock_ms(CLOCK_MONOTONIC);
+    cpu_start = clock_ms(CLOCK_THREAD_CPUTIME_ID);
+    allocations_start = allocation_count;
+    allocated_bytes_start = allocation_bytes;
+}
+
+void PhaseTimer::stop(uint64_t output_bytes) {
+    if (stats == nullptr) return;
+    PhaseStats phase;
+    phase.name = name;
+    phase.wall_ms = clock_ms(CLOCK_MONOTONIC) - wall_start;
+    phase.cpu_ms = clock_ms(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+    phase.allocations = allocation_count - allocations_start;
+    phase.allocated_bytes = allocation_bytes - allocated_bytes_start;
+    phase.output_bytes = output_bytes;
+    phase.peak_rss_kb = peak_rss_kb();
+    stats->phases.push_back(phase);
+    stats = nullptr;
+}
+
+std::string stats_to_text(const std::string &source_filename, const Stats &stats) {
+    std::string text = "===== compile statistics: " + source_filename + " =====\n";
+    char line[160];
+    snprintf(line, sizeof(line), "tokens: %llu, parse tree nodes: %llu, arena: %llu bytes\n",
+             (unsigned long long)stats.tokens, (unsigned long long)stats.nodes,
+             (unsigned long long)stats.arena_bytes);
+    text += line;
+    if (!stats.cache.empty()) text += "cache: " + stats.cache + "\n";
+    snprintf(line, sizeof(line), "%-10s %10s %10s %8s %12s %12s %10s\n",
+             "phase", "wall ms", "cpu ms", "allocs", "alloc bytes", "out bytes", "peak KiB");
+    text += line;
+    for (auto &phase : stats.phases) {
+        snprintf(line, sizeof(line), "%-10s %10.3f %10.3f %8llu %12llu %12llu %10ld\n",
+                 phase.name.c_str(), phase.wall_ms, phase.cpu_ms, (unsigned long long)phase.allocations,
+                 (unsigned long long)phase.allocated_bytes, (unsigned long long)phase.output_bytes,
+                 phase.peak_rss_kb);
+        text += line;
+    }
+    return text;
+}
+
+static std::string json_string(const std::string &s) {
+    std::string quoted = "\"";
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += (char)c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        } else {
+            quoted += (char)c;
+        }
+    }
+    return quoted + "\"";
+}
+
+std::string stats_to_json(const std::string &source_filename, const Stats &stats) {
+    std::string json = "{\"source\": " + json_string(source_filename)
+        + ", \"tokens\": " + std::to_string(stats.tokens)
+        + ", \"nodes\": " + std::to_string(stats.nodes)
+        + ", \"arena_bytes\": " + std::to_string(stats.arena_bytes)
+        + (stats.cache.empty() ? "" : ", \"cache\": " + json_string(stats.cache))
+        + ", \"phases\": [";
+    char number[64];
+    for (size_t i = 0; i < stats.phases.size(); ++i) {
+        const PhaseStats &phase = stats.phases[i];
+        json += i > 0 ? ", " : "";
+        json += "{\"name\": " + json_string(phase.name);
+        snprintf(number, sizeof(number), "%.3f", phase.wall_ms);
+        json += std::string(", \"wall_ms\": ") + number;
+        snprintf(number, sizeof(number), "%.3f", phase.cpu_ms);
+        json += std::string(", \"cpu_ms\": ") + number;
+        json += ", \"allocations\": " + std::to_string(phase.allocations);
+        json += ", \"allocated_bytes\": " + std::to_string(phase.allocated_bytes);
+        json += ", \"output_bytes\": " + std::to_string(phase.output_bytes);
+        json += ", \"peak_rss_kb\": " + std::to_string(phase.peak_rss_kb) + "}";
+    }
+    return json + "]}";
+}
@@ -0,0 +1,80 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 23rd, 2026
+ *
+ * This file defines the per-phase measurements of a compilation reported by --stats.
+ */
+
+#ifndef CSC4180_STATS_HPP
+#define CSC4180_STATS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Measurements of one phase of a compilation
+ */
+struct PhaseStats {
+    std::string name;
+    double wall_ms = 0;
+    double cpu_ms = 0;              // CPU time of the compiling thread
+    uint64_t allocations = 0;       // operator new calls of the compiling thread
+    uint64_t allocated_bytes = 0;
+    uint64_t output_bytes = 0;      // text produced by the phase (.dot, IR, assembly)
+    long peak_rss_kb = 0;           // peak resident set of the whole process at the end of the phase
+};
+
+/**
+ * Measurements of a compilation, collected when Options::collect_stats is set
+ */
+struct Stats {
+    uint64_t tokens = 0;
+    uint64_t nodes = 0;             // nodes of the parse tree
+    uint64_t arena_bytes = 0;       // bytes reserved by the arena of the Result
+    std::string cache;              // "hit" or "miss" with a compile cache, empty without
+    std::vector<PhaseStats> phases;
+};
+
+/**
+ * Measures one phase, from construction to stop()
+ */
+class PhaseTimer {
+public:
+    /**
+     * @param stats: where the phase is recorded, nullptr to measure nothing
+     * @param name: name of the phase in the report
+     */
+    PhaseTimer(Stats* stats, const char* name);
+
+    /**
+     * End the phase and record it
+     * @param output_bytes: size of the text the phase produced
+     */
+    void stop(uint64_t output_bytes = 0);
+
+private:
+    Stats* stats;
+    const char* name;
+    double wall_start = 0;
+    double cpu_start = 0;
+    uint64_t allocations_start = 0;
+    uint64_t allocated_bytes_start = 0;
+};
+
+/**
+ * @return a table of the phases, in the style of -ftime-report
+ */
+std::string stats_to_text(const std::string &source_filename, const Stats &stats);
+
+/**
+ * @return one JSON object: {"source": ..., "tokens": ..., "nodes": ..., "arena_bytes": ..., "cache": ...,
+ *         "phases": [...]}
+ */
+std::string stats_to_json(const std::string &source_filename, const Stats &stats);
+
+#endif  // CSC4180_STATS_HPP
@@ -0,0 +1,339 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 1: Micro Language Compiler
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file implements test_driver, which runs the pipeline of run_compiler.sh (or run_native_backend.sh)
+ * on every testcase concurrently, times each stage and diffs the outputs against the expected ones.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+/**
+ * One step of a pipeline, a shell command run in the testcases directory, {test} stands for the test name
+ */
+struct Stage {
+    const char* name;
+    const char* command;
+};
+
+/**
+ * The steps from a source program to its output, and where the output and the expected output are
+ */
+struct Pipeline {
+    const char* name;
+    const char* setup;                  // command run once before the tests, nullptr for none
+    std::vector<Stage> stages;
+    const char* output;
+    const char* expected;
+};
+
+static const char* const SOURCE_EXTENSION = ".m";
+static const char* const DIRECTORIES[] = {
+    "tokens", "cst", "ast", "llvm_ir", "riscv_assembly", "executable", "input", "output"
+};
+
+static const Pipeline PIPELINES[] = {
+    // run_compiler.sh
+    {"llvm", nullptr, {
+        {"tokens", "../src/compiler -s ./{test}.m > ./tokens/{test}.txt"},
+        {"cst", "../src/compiler -c -d ./cst/{test}.dot ./{test}.m"},
+        {"ast+ir", "../src/compiler -d ./ast/{test}.dot -o ./llvm_ir/{test}.ll ./{test}.m"},
+        {"opt", "opt ./llvm_ir/{test}.ll -S --O3 -o ./llvm_ir/{test}_opt.ll"},
+        {"llc", "llc -march=riscv64 ./llvm_ir/{test}_opt.ll -o ./riscv_assembly/{test}.s"},
+        {"gcc", "riscv64-unknown-linux-gnu-gcc ./riscv_assembly/{test}.s -o ./executable/{test}"},
+        {"qemu", "qemu-riscv64 -L /opt/riscv/sysroot ./executable/{test} < ./input/{test}.txt"
+                 " > ./output/{test}-local.txt"},
+    }, "./output/{test}-local.txt", "./output/{test}-expected.txt"},
+    // run_native_backend.sh
+    {"native", nullptr, {
+        {"asm", "../src/compiler -S ./riscv_assembly/{test}-native.s ./{test}.m"},
+        {"gcc", "riscv64-unknown-linux-gnu-gcc ./riscv_assembly/{test}-native.s -o ./executable/{test}-native"},
+        {"qemu", "qemu-riscv64 -L /opt/riscv/sysroot ./executable/{test}-native < ./input/{test}.txt"
+                 " > ./output/{test}-native.txt"},
+    }, "./output/{test}-native.txt", "./output/{test}-expected.txt"},
+    // the bytecode interpreter, needs no cross toolchain
+    {"vm", nullptr, {
+        {"run", "../src/compiler -r ./{test}.m < ./input/{test}.txt > ./output/{test}-vm.txt"},
+    }, "./output/{test}-vm.txt", "./output/{test}-expected.txt"},
+};
+
+/**
+ * What happened to one testcase
+ */
+struct TestResult {
+    std::string name;
+    std::vector<double> stage_ms;       // wall time of each stage that ran
+    std::string failed_stage;           // empty if every stage succeeded
+    std::string log;                    // output of the stages that is not redirected, and the diff
+    std::string status;                 // pass or FAIL
+};
+
+static std::string expand(const char* pattern, const std::string &test) {
+    std::string command = pattern;
+    for (size_t at = command.find("{test}"); at != std::string::npos; at = command.find("{test}", at + test.size()))
+        command.replace(at, 6, test);
+    return command;
+}
+
+/**
+ * Run a shell command, collecting its stdout and stderr
+ * @return whether it exited with status 0
+ */
+static bool run_command(const std::string &command, std::string &log) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) return false;
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDERR_FILENO);
+    const char* argv[] = {"sh", "-c", command.c_str(), nullptr};
+    pid_t pid;
+    int error = posix_spawn(&pid, "/bin/sh", &actions, nullptr, const_cast<char**>(argv), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (error != 0) {
+        close(fds[0]);
+        log += "Error: cannot run /bin/sh: " + std::string(strerror(error)) + "\n";
+        return false;
+    }
+    char buffer[4096];
+    for (;;) {
+        ssize_t n = read(fds[0], buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        log.append(buffer, n);
+    }
+    close(fds[0]);
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool read_file(const std::string &filename, std::string &content) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+/**
+ * @return the first line where the output differs from the expected one, empty if they are equal
+ */
+static std::string first_difference(const std::string &output, const std::string &expected) {
+    if (output == expected) return "";
+    std::istringstream a(output), b(expected);
+    std::string line_a, line_b;
+    for (int line = 1; ; ++line) {
+        bool more_a = (bool)std::getline(a, line_a);
+        bool more_b = (bool)std::getline(b, line_b);
+        if (!more_a && !more_b) return "outputs differ in trailing bytes\n";
+        if (!more_a || !more_b || line_a != line_b) {
+            return "line " + std::to_string(line) + ": got \"" + (more_a ? line_a : "<end>")
+                + "\", expected \"" + (more_b ? line_b : "<end>") + "\"\n";
+        }
+    }
+}
+
+static void run_test(const Pipeline &pipeline, TestResult &result) {
+    for (auto &stage : pipeline.stages) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = run_command(expand(stage.command, result.name), result.log);
+        auto end = std::chrono::steady_clock::now();
+        result.stage_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        if (!ok) {
+            result.failed_stage = stage.name;
+            result.status = "FAIL";
+            return;
+        }
+    }
+    std::string output, expected;
+    // a test without an expected output checks nothing, so it fails rather than passing unnoticed
+    std::string expected_filename = expand(pipeline.expected, result.name);
+    if (!read_file(expected_filename, expected)) {
+        result.log += "no expected output " + expected_filename + "\n";
+        result.status = "FAIL";
+        return;
+    }
+    read_file(expand(pipeline.output, result.name), output);
+    std::string difference = first_difference(output, expected);
+    result.log += difference;
+    result.status = difference.empty() ? "pass" : "FAIL";
+}
+
+// test2 before test10
+static bool natural_less(const std::string &a, const std::string &b) {
+    size_t digits_a = a.find_last_not_of("0123456789") + 1;
+    size_t digits_b = b.find_last_not_of("0123456789") + 1;
+    if (a.compare(0, digits_a, b, 0, digits_b) != 0 || digits_a == a.size() || digits_b == b.size()) return a < b;
+    std::string number_a = a.substr(digits_a), number_b = b.substr(digits_b);
+    if (number_a.size() != number_b.size()) return number_a.size() < number_b.size();
+    return number_a < number_b;
+}
+
+/**
+ * @return the names of the source programs in the testcases directory, without extension
+ */
+static std::vector<std::string> discover_tests() {
+    std::vector<std::string> tests;
+    DIR* dir = opendir(".");
+    if (dir == nullptr) return tests;
+    size_t extension_length = strlen(SOURCE_EXTENSION);
+    while (struct dirent* item = readdir(dir)) {
+        std::string name = item->d_name;
+        if (name.size() > extension_length
+            && name.compare(name.size() - extension_length, extension_length, SOURCE_EXTENSION) == 0) {
+            tests.push_back(name.substr(0, name.size() - extension_length));
+        }
+    }
+    closedir(dir);
+    std::sort(tests.begin(), tests.end(), natural_less);
+    return tests;
+}
+
+static void print_summary(const Pipeline &pipeline, const std::vector<TestResult> &results, double total_ms) {
+    char cell[64];
+    std::string table = "test      ";
+    for (auto &stage : pipeline.stages) {
+        snprintf(cell, sizeof(cell), "%10s", stage.name);
+        table += cell;
+    }
+    table += "  result\n";
+    std::vector<double> sum(pipeline.stages.size(), 0), max(pipeline.stages.size(), 0);
+    for (auto &result : results) {
+        snprintf(cell, sizeof(cell), "%-10s", result.name.c_str());
+        table += cell;
+        for (size_t i = 0; i < pipeline.stages.size(); ++i) {
+            if (i < result.stage_ms.size()) {
+                snprintf(cell, sizeof(cell), "%10.1f", result.stage_ms[i]);
+                sum[i] += result.stage_ms[i];
+                max[i] = std::max(max[i], result.stage_ms[i]);
+            } else {
+                snprintf(cell, sizeof(cell), "%10s", "-");
+            }
+            table += cell;
+        }
+        table += "  " + result.status;
+        if (!result.failed_stage.empty()) table += " (" + result.failed_stage + ")";
+        table += "\n";
+    }
+    const char* rows[] = {"sum ms", "max ms"};
+    for (int row = 0; row < 2; ++row) {
+        snprintf(cell, sizeof(cell), "%-10s", rows[row]);
+        table += cell;
+        for (size_t i = 0; i < pipeline.stages.size(); ++i) {
+            snprintf(cell, sizeof(cell), "%10.1f", row == 0 ? sum[i] : max[i]);
+            table += cell;
+        }
+        table += "\n";
+    }
+    int passed = 0, failed = 0;
+    for (auto &result : results) {
+        if (result.status == "pass") ++passed;
+        if (result.status == "FAIL") ++failed;
+    }
+    snprintf(cell, sizeof(cell), "%.1f", total_ms);
+    table += std::to_string(results.size()) + " tests, " + std::to_string(passed) + " passed, "
+        + std::to_string(failed) + " failed, " + cell + " ms wall\n";
+    std::cout << table;
+}
+
+int main(int argc, char const *argv[]) {
+    const Pipeline* pipeline = &PIPELINES[0];
+    unsigned num_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string testcases = "../testcases";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            num_threads = std::max(1, atoi(argv[++i]));
+        } else if (arg == "-p" && i + 1 < argc) {
+            pipeline = nullptr;
+            for (auto &candidate : PIPELINES) {
+                if (candidate.name == std::string(argv[i + 1])) pipeline = &candidate;
+            }
+            if (pipeline == nullptr) {
+                std::cerr << "Error: unknown pipeline " << argv[i + 1] << "\n";
+                return -1;
+            }
+            ++i;
+        } else if (arg[0] != '-') {
+            testcases = arg;
+        } else {
+            std::cerr << "Usage: test_driver [-j jobs] [-p llvm|native|vm] [testcases-directory]\n";
+            return -1;
+        }
+    }
+    if (chdir(testcases.c_str()) != 0) {
+        std::cerr << "Error: cannot enter " << testcases << "\n";
+        return -1;
+    }
+    for (auto directory : DIRECTORIES)
+        mkdir(directory, 0755);
+    std::vector<TestResult> results;
+    for (auto &test : discover_tests()) {
+        results.emplace_back();
+        results.back().name = test;
+    }
+    if (results.empty()) {
+        std::cerr << "Error: no *" << SOURCE_EXTENSION << " testcase in " << testcases << "\n";
+        return -1;
+    }
+
+    if (pipeline->setup != nullptr) {
+        std::string log;
+        if (!run_command(pipeline->setup, log)) {
+            std::cout << "Error: setup failed: " << pipeline->setup << "\n" << log;
+            return 1;
+        }
+    }
+    // each worker takes the next test that is not taken yet and runs its stages in order
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next_test(0);
+    auto worker = [&]() {
+        for (size_t i = next_test++; i < results.size(); i = next_test++)
+            run_test(*pipeline, results[i]);
+    };
+    if (num_threads > results.size()) num_threads = results.size();
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < num_threads; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads)
+        thread.join();
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    print_summary(*pipeline, results, total_ms);
+    bool failed = false;
+    for (auto &result : results) {
+        if (result.status != "FAIL") continue;
+        failed = true;
+        std::cout << "===== " << result.name << " =====\n" << result.log;
+    }
+    return failed ? 1 : 0;
+}
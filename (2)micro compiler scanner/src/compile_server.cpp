@@ -0,0 +1,303 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 2: Oat v.1 Scanner
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file implements the scan server and its client defined in compile_server.hpp
+ */
+
+#include "compile_server.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdio_ext.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * Request: u32 payload size, sent with stdin/stdout/stderr attached (SCM_RIGHTS), then the payload
+ * "<working directory>\0<argv[0]>\0<argv[1]>\0..."
+ * Reply: i32 exit status
+ */
+static const int NUM_FDS = 3;
+
+static bool read_all(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool write_all(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool make_address(const std::string &socket_path, struct sockaddr_un &address) {
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) return false;
+    memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    return true;
+}
+
+// @return the connected socket, -1 if no server is listening
+static int connect_to(const std::string &socket_path) {
+    struct sockaddr_un address;
+    if (socket_path.empty() || !make_address(socket_path, address)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// @return whether the other end of a connected socket runs as the same user as this process
+static bool same_user(int connection) {
+    struct ucred peer;
+    socklen_t size = sizeof(peer);
+    return getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &peer, &size) == 0 && peer.uid == getuid();
+}
+
+std::string default_socket_path(const std::string &name) {
+    const char* path = getenv("CSC4180_SERVER_SOCKET");
+    if (path != nullptr && path[0] != '\0') return path;
+    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir != nullptr && runtime_dir[0] != '\0') return std::string(runtime_dir) + "/csc4180-" + name + ".sock";
+    // /tmp is shared: the socket goes into a directory only this user can enter, the first process creates it
+    std::string directory = "/tmp/csc4180-" + std::to_string(getuid());
+    mkdir(directory.c_str(), 0700);
+    struct stat info;
+    if (lstat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode) || info.st_uid != getuid()
+        || (info.st_mode & 077) != 0) {
+        std::cerr << "Error: " << directory << " is not a private directory of this user\n";
+        return "";
+    }
+    return directory + "/" + name + ".sock";
+}
+
+/**
+ * @param fds: set to the descriptors of the client
+ * @return whether a whole request was received
+ */
+static bool receive_request(int connection, std::string &payload, int fds[NUM_FDS]) {
+    uint32_t size = 0;
+    struct iovec iov = {&size, sizeof(size)};
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * NUM_FDS)];
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t n;
+    do {
+        n = recvmsg(connection, &message, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    if (header == nullptr || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS
+        || header->cmsg_len != CMSG_LEN(sizeof(int) * NUM_FDS)) {
+        return false;
+    }
+    memcpy(fds, CMSG_DATA(header), sizeof(int) * NUM_FDS);
+    // the size may arrive in pieces, the descriptors always come with its first byte
+    bool complete = read_all(connection, reinterpret_cast<char*>(&size) + n, sizeof(size) - n);
+    if (complete) {
+        payload.resize(size);
+        complete = read_all(connection, &payload[0], size);
+    }
+    if (!complete) {
+        for (int i = 0; i < NUM_FDS; ++i)
+            close(fds[i]);
+    }
+    return complete;
+}
+
+/**
+ * Run one command with the working directory and the standard streams of the client
+ * @return exit status of the command
+ */
+static int run_request(const std::string &payload, const int fds[NUM_FDS], const CommandHandler &handler) {
+    if (payload.empty() || payload.back() != '\0') return -1;
+    std::vector<const char*> args;
+    for (size_t start = 0; start < payload.size(); start = payload.find('\0', start) + 1)
+        args.push_back(payload.c_str() + start);
+    if (args.size() < 2) return -1;
+    int saved_fds[NUM_FDS];
+    for (int i = 0; i < NUM_FDS; ++i) {
+        saved_fds[i] = fcntl(i, F_DUPFD_CLOEXEC, NUM_FDS);
+        dup2(fds[i], i);
+    }
+    int saved_cwd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    int status;
+    if (chdir(args[0]) != 0) {
+        std::cerr << "Error: cannot enter " << args[0] << "\n";
+        status = -1;
+    } else {
+        status = handler(args.size() - 1, args.data() + 1);
+    }
+    // nothing of this command may leak into the next one
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+    __fpurge(stdin);
+    clearerr(stdin);
+    std::cin.clear();
+    if (saved_cwd >= 0) {
+        if (fchdir(saved_cwd) != 0) perror("fchdir");
+        close(saved_cwd);
+    }
+    for (int i = 0; i < NUM_FDS; ++i) {
+        dup2(saved_fds[i], i);
+        close(saved_fds[i]);
+    }
+    return status;
+}
+
+int serve(const std::string &socket_path, const CommandHandler &handler) {
+    struct sockaddr_un address;
+    if (socket_path.empty()) return -1;
+    if (!make_address(socket_path, address)) {
+        std::cerr << "Error: socket path too long: " << socket_path << "\n";
+        return -1;
+    }
+    int running = connect_to(socket_path);
+    if (running >= 0) {
+        close(running);
+        std::cerr << "Error: a server is already listening on " << socket_path << "\n";
+        return -1;
+    }
+    unlink(socket_path.c_str());
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    // the socket file is created with the mode of the umask, only this user may connect
+    mode_t umask_before = umask(077);
+    bool bound = listener >= 0 && bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0;
+    umask(umask_before);
+    if (!bound || listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "Error: cannot listen on " << socket_path << ": " << strerror(errno) << "\n";
+        return -1;
+    }
+    // a client that goes away must not kill the server
+    signal(SIGPIPE, SIG_IGN);
+    std::cerr << "listening on " << socket_path << "\n";
+    for (;;) {
+        int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "Error: accept: " << strerror(errno) << "\n";
+            break;
+        }
+        // a client runs commands as this user with its descriptors, so only this user may be a client
+        if (!same_user(connection)) {
+            std::cerr << "Error: refused a client of another user\n";
+            close(connection);
+            continue;
+        }
+        std::string payload;
+        int fds[NUM_FDS];
+        if (receive_request(connection, payload, fds)) {
+            int32_t status = run_request(payload, fds, handler);
+            for (int i = 0; i < NUM_FDS; ++i)
+                close(fds[i]);
+            write_all(connection, &status, sizeof(status));
+        }
+        close(connection);
+    }
+    close(listener);
+    return -1;
+}
+
+bool forward(const std::string &socket_path, int argc, char const *argv[], int &status) {
+    int connection = connect_to(socket_path);
+    if (connection < 0) return false;
+    // the client's descriptors and working directory are only handed to a server of the same user
+    if (!same_user(connection)) {
+        close(connection);
+        std::cerr << "Error: the server at " << socket_path << " belongs to another user\n";
+        status = -1;
+        return true;
+    }
+    std::vector<char> cwd(4096);
+    while (getcwd(cwd.data(), cwd.size()) == nullptr && errno == ERANGE)
+        cwd.resize(cwd.size() * 2);
+    std::string payload(cwd.data(), strlen(cwd.data()) + 1);
+    for (int i = 0; i < argc; ++i)
+        payload.append(argv[i], strlen(argv[i]) + 1);
+    uint32_t size = payload.size();
+    struct iovec iov = {&size, sizeof(size)};
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * NUM_FDS)];
+    memset(control, 0, sizeof(control));
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int) * NUM_FDS);
+    int fds[NUM_FDS] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    memcpy(CMSG_DATA(header), fds, sizeof(fds));
+    ssize_t sent;
+    do {
+        sent = sendmsg(connection, &message, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    int32_t reply = 0;
+    bool done = sent > 0 && write_all(connection, reinterpret_cast<char*>(&size) + sent, sizeof(size) - sent)
+        && write_all(connection, payload.data(), payload.size()) && read_all(connection, &reply, sizeof(reply));
+    close(connection);
+    if (!done) {
+        std::cerr << "Error: the server at " << socket_path << " closed the connection\n";
+        reply = -1;
+    }
+    status = reply;
+    return true;
+}
+
+int run_client(const std::string &name, int argc, char const *argv[]) {
+    int status;
+    if (forward(default_socket_path(name), argc, argv, status)) return status;
+    // no server: the client is a drop-in for the binary next to it
+    std::vector<char> self(4096);
+    ssize_t n = readlink("/proc/self/exe", self.data(), self.size() - 1);
+    std::string path = n > 0 ? std::string(self.data(), n) : std::string(argv[0]);
+    size_t slash = path.find_last_of('/');
+    path = (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + name;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; ++i)
+        args.push_back(const_cast<char*>(argv[i]));
+    args.push_back(nullptr);
+    execv(path.c_str(), args.data());
+    std::cerr << "Error: no server is listening and " << path << " cannot be executed\n";
+    return -1;
+}
@@ -0,0 +1,17 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 2: Oat v.1 Scanner
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file defines the main function of scanner_client, which takes the command line of the scanner
+ * and runs it on a resident `scanner --serve`, skipping the NFA/DFA construction.
+ */
+
+#include "compile_server.hpp"
+
+int main(int argc, char const *argv[]) {
+    return run_client("scanner", argc, argv);
+}
@@ -14,6 +14,7 @@ import sys                          # for CLI argument parsing
 import llvmlite.binding as llvm     # for llvmlite IR generation
 import llvmlite.ir as ir            # for llvmlite IR generation
 import pydot                        # for .dot file parsing
+import struct                       # for .ast file parsing
 from enum import Enum               # for enum in python
 
 DEBUG = False
@@ -150,9 +151,34 @@ class TreeNode:
         self.children.append(child_node)
 
 def print_tree(node, level = 0):
-    print("  " * level + '|' + node.lexeme.replace("\n","\\n") + ", " + node.nodetype.name)
-    for child in node.children:
-        print_tree(child, level + 1)
+    stack = [(node, level)]
+    while stack:
+        node, level = stack.pop()
+        print("  " * level + '|' + node.lexeme.replace("\n","\\n") + ", " + node.nodetype.name)
+        stack.extend((child, level + 1) for child in reversed(node.children))
+
+def walk(root, handler_map, default_handler):
+    """
+    Run the handlers of a tree with an explicit work stack instead of recursion,
+    so the depth of the tree is not bounded by Python's recursion limit
+
+    A handler does the work of its node and returns the steps left, in order: child TreeNodes to walk
+    and callables to run once the nodes before them are done (None if there is nothing left)
+
+    Args:
+        - root(TreeNode)
+        - handler_map(dict): NodeType -> handler function
+        - default_handler: handler of the other NodeTypes
+    """
+    work = [root]
+    while work:
+        step = work.pop()
+        if isinstance(step, TreeNode):
+            steps = handler_map.get(step.nodetype, default_handler)(step)
+            if steps:
+                work.extend(reversed(steps))
+        else:
+            step()
 
 def visualize_tree(root_node, output_path):
     """
@@ -173,16 +199,22 @@ def visualize_tree(root_node, output_path):
         label += "\ntype: " + tree_node.datatype.name
         node.set("label", label)
         return node
-    # Recursively visualize node
+    # Visualize nodes in pre-order, with a stack of the children left to add under each node
     def visualize(node, graph):
         # Add Root Node Only
         if node.index == 0:
             graph.add_node(pydot_node(node))
         # Add Children Nodes and Edges
-        for child in node.children:
+        stack = [(node, iter(node.children))]
+        while stack:
+            parent, children = stack[-1]
+            child = next(children, None)
+            if child is None:
+                stack.pop()
+                continue
             graph.add_node(pydot_node(child))
-            graph.add_edge(pydot.Edge(node.index, child.index))
-            visualize(child, graph)
+            graph.add_edge(pydot.Edge(parent.index, child.index))
+            stack.append((child, iter(child.children)))
     # Output visualization png graph
     graph = pydot.Dot(graph_type="graph")
     visualize(root_node, graph)
@@ -202,7 +234,7 @@ def construct_tree_from_dot(dot_filepath):
     graph = pydot.graph_from_dot_file(dot_filepath)[0]
     # Initialize Python TreeNode structure
     nodes = []
-    # code_type_map = { member.value: member for member in NodeType }
+    code_type_map = { member.value: member for member in NodeType }
     # Add nodes
     for node in graph.get_nodes():
         if len(node.get_attributes()) == 0: continue
@@ -212,7 +244,7 @@ def construct_tree_from_dot(dot_filepath):
         lexeme = node.get_attributes()['lexeme'][1:-1]  # exclude enclosing quotes
         tree_node = TreeNode(index, lexeme)
         tree_node.lexeme = lexeme
-        tree_node.nodetype = { member.value: member for member in NodeType }[label] if any(label == member.value for member in NodeType) else NodeType.NONE
+        tree_node.nodetype = code_type_map.get(label, NodeType.NONE)
         if DEBUG: print("Index: ", index, ", lexeme: ", lexeme, ", nodetype: ", tree_node.nodetype)
         nodes.append(tree_node)
     # Add Edges
@@ -223,6 +255,80 @@ def construct_tree_from_dot(dot_filepath):
     # root node should always be the first node
     return nodes[0]
 
+AST_MAGIC = b"OATAST\0"
+AST_FORMAT_VERSION = 2
+AST_FLAG_ANALYZED = 1     # semantic analysis has been done by the C++ frontend
+
+# Labels of the C++ SymbolClass values in declaration order, i.e. symbol_class_to_str() in node.cpp
+SYMBOL_CLASS_LABELS = [
+    "<program>", "<global_decl>", "<function_decl>", "<var_decls>", "<var_decl>", "<args>", "<arg>", "<ref>",
+    "<global_exps>", "<stmts>", "<exps>", "<new init value>", "<new init size>", "<array index>", "<func call>",
+    "NULL", "TRUE", "FALSE", "void", "int", "string", "bool",
+    "IF", "ELSE", "WHILE", "FOR", "RETURN", "NEW",
+    "STAR", "PLUS", "MINUS", "LSHIFT", "RLSHIFT", "RASHIFT", "LESS", "LESSEQ", "GREAT", "GREATEQ", "EQ", "NEQ",
+    "LAND", "LOR", "BAND", "BOR",
+    "NOT", "TILDE",
+    "ASSIGN", "ID", "INTLITERAL", "STRINGLITERAL",
+]
+
+def construct_tree_from_ast(ast_filepath, with_semantics = True):
+    """
+    Read .ast file, the binary AST from parser (format described in node.hpp)
+
+    The file is read at once, node records are in pre-order and each one tells its number of children,
+    so the tree is rebuilt in one pass with a stack of the nodes still waiting for children.
+
+    Args:
+        - ast_filepath(str): path of the .ast file
+        - with_semantics(bool): take the unique names and data types resolved by the C++ frontend
+
+    Return:
+        - (TreeNode, bool): the root node of the AST, and whether its semantic analysis is done
+    """
+    with open(ast_filepath, "rb") as f:
+        data = f.read()
+    if data[:7] != AST_MAGIC or data[7] != AST_FORMAT_VERSION:
+        raise ValueError("Not a version " + str(AST_FORMAT_VERSION) + " .ast file: " + ast_filepath)
+    node_count, string_table_size, flags = struct.unpack_from("<III", data, 8)
+    analyzed = with_semantics and (flags & AST_FLAG_ANALYZED) != 0
+    records_start = 20
+    strings_start = records_start + 20 * node_count
+    strings = data[strings_start:strings_start + string_table_size]
+    code_type_map = { member.value: member for member in NodeType }
+    nodetypes = [code_type_map.get(label, NodeType.NONE) for label in SYMBOL_CLASS_LABELS]
+    root = None
+    pending = []    # [TreeNode, number of children not read yet]
+    records = struct.iter_unpack("<BB2xIIII", data[records_start:strings_start])
+    for index, (symbol_class, datatype, child_count, offset, length, scope_id) in enumerate(records):
+        tree_node = TreeNode(index, strings[offset:offset + length].decode("utf-8"))
+        tree_node.nodetype = nodetypes[symbol_class]
+        if analyzed:
+            tree_node.datatype = DataType(datatype)
+            if scope_id != 0:
+                tree_node.id = symbol_table.unique_name(tree_node.lexeme, scope_id)
+        if DEBUG: print("Index: ", index, ", lexeme: ", tree_node.lexeme, ", nodetype: ", tree_node.nodetype)
+        if pending:
+            parent = pending[-1]
+            parent[0].add_child(tree_node)
+            parent[1] -= 1
+            if parent[1] == 0: pending.pop()
+        else:
+            root = tree_node
+        if child_count > 0:
+            pending.append([tree_node, child_count])
+    return root, analyzed
+
+def construct_tree(ast_path, with_semantics = False):
+    """
+    Load the AST from parser, .ast (binary) files directly and anything else as .dot
+
+    Return:
+        - (TreeNode, bool): the root node of the AST, and whether its semantic analysis is done
+    """
+    if ast_path.endswith(".ast"):
+        return construct_tree_from_ast(ast_path, with_semantics)
+    return construct_tree_from_dot(ast_path), False
+
 class NodeType(Enum):
     """
     Map lexeme of AST node to code type in IR generation
@@ -418,9 +524,10 @@ def get_id_pointer(node):
 
 def codegen(node):
     """
-    Recursively do LLVM IR generation
+    Do LLVM IR generation of a subtree, walked with an explicit work stack
 
-    Call corresponding handler function for each NodeType
+    Call corresponding handler function for each NodeType, it returns the children to generate
+    and the callables to run between them (see walk)
 
     Different NodeTypes may be mapped to the same handelr function
 
@@ -442,17 +549,12 @@ def codegen(node):
         NodeType.FOR_LOOP: codegen_handler_for_loop,
         NodeType.WHILE_LOOP: codegen_handler_while_loop
     }
-    codegen_func = codegen_func_map.get(node.nodetype)
-    if codegen_func:
-        codegen_func(node)
-    else:
-        codegen_handler_default(node)
+    walk(node, codegen_func_map, codegen_handler_default)
 
 # Some sample handler functions for IR codegen
 # TODO: implement more handler functions for various node types
 def codegen_handler_default(node):
-    for child in node.children:
-        codegen(child)
+    return node.children
 
 def codegen_handler_global_decl(node):
     """
@@ -480,7 +582,7 @@ def codegen_handler_func_decl(node):
     entry_block = func.append_basic_block(name="entry")
     global builder
     builder = ir.IRBuilder(entry_block)
-    codegen_handler_default(node)
+    return codegen_handler_default(node)
 
 def codegen_handler_var_decl(node):
     """
@@ -528,39 +630,42 @@ def codegen_handler_return(node):
 
 def codegen_handler_assign(node):
     left = get_id_pointer(node.children[0])
-    if node.children[1].nodetype == NodeType.PLUS:
-        right = codegen_handler_plus(node.children[1])
-        builder.store(right, left)
-    elif node.children[1].nodetype == NodeType.MINUS:
-        right = codegen_handler_minus(node.children[1])
-        builder.store(right, left)
-    else:
-        right = get_var(node.children[1])
-        builder.store(right, left)
+    right = codegen_expression(node.children[1])
+    builder.store(right, left)
 
-def codegen_handler_plus(node):
-    variable_list = []
-    result = ir.Constant(ir.IntType(32), 0)
-    for child in node.children:
-        if child.nodetype == NodeType.PLUS:
-            variable_list.append(codegen_handler_plus(child))
-        elif child.nodetype == NodeType.MINUS:
-            variable_list.append(codegen_handler_minus(child))
+def codegen_expression(node):
+    """
+    Value of a + and - expression, evaluated in post-order with a stack of nodes and a stack of values,
+    so that deeply nested expressions do not hit the recursion limit
+    """
+    operator_map = {
+        NodeType.PLUS: codegen_handler_plus,
+        NodeType.MINUS: codegen_handler_minus,
+    }
+    values = []
+    work = [(node, False)]      # (node, whether the values of its children are ready)
+    while work:
+        current, operands_ready = work.pop()
+        handler = operator_map.get(current.nodetype)
+        if handler is None:
+            values.append(get_var(current))
+        elif not operands_ready:
+            work.append((current, True))
+            work.extend((child, False) for child in reversed(current.children))
         else:
-            variable_list.append(get_var(child))
+            count = len(current.children)
+            operands = values[len(values) - count:]
+            del values[len(values) - count:]
+            values.append(handler(current, operands))
+    return values[0]
+
+def codegen_handler_plus(node, variable_list):
+    result = ir.Constant(ir.IntType(32), 0)
     for constant in variable_list:
         result = builder.add(result, constant)
     return result
 
-def codegen_handler_minus(node):
-    variable_list = []
-    for child in node.children:
-        if child.nodetype == NodeType.PLUS:
-            variable_list.append(codegen_handler_plus(child))
-        elif child.nodetype == NodeType.MINUS:
-            variable_list.append(codegen_handler_minus(child))
-        else:
-            variable_list.append(get_var(child))
+def codegen_handler_minus(node, variable_list):
     result = variable_list[0]
     result = builder.sub(result, variable_list[1])
     return result
@@ -589,19 +694,17 @@ def codegen_handler_if_stmt(node):
         merge_block = current_function.append_basic_block(name="merge_block")
         # goto merge_block
         builder.cbranch(condition, if_block, merge_block)
+    steps = []
     for child in node.children:
         if child.nodetype == NodeType.STMTS:
-            builder.position_at_end(if_block)
-            codegen(child)
-            builder.branch(merge_block)
+            steps += [lambda: builder.position_at_end(if_block), child, lambda: builder.branch(merge_block)]
         if child.nodetype == NodeType.ELSE_STMT:
-            builder.position_at_end(else_block)
-            codegen(child)
-            builder.branch(merge_block)
-    builder.position_at_end(merge_block)
+            steps += [lambda: builder.position_at_end(else_block), child, lambda: builder.branch(merge_block)]
+    steps.append(lambda: builder.position_at_end(merge_block))
+    return steps
 
 def codegen_handler_else_stmt(node):
-    codegen_handler_default(node)
+    return codegen_handler_default(node)
 
 def codegen_handler_for_loop(node):
     compare_map = {
@@ -617,22 +720,24 @@ def codegen_handler_for_loop(node):
     loop_body_block = current_function.append_basic_block(name="for_loop_body")
     loop_end_block = current_function.append_basic_block(name="for_loop_end")
 
-    codegen(node.children[0])
-    builder.branch(loop_cond_block)
-    builder.position_at_end(loop_cond_block)
+    def condition():
+        builder.branch(loop_cond_block)
+        builder.position_at_end(loop_cond_block)
 
+        left_var = get_var(node.children[1].children[0])
+        right_var = get_var(node.children[1].children[1])
+        condition = builder.icmp_signed(compare_map[node.children[1].nodetype], left_var, right_var)
 
-    left_var = get_var(node.children[1].children[0])
-    right_var = get_var(node.children[1].children[1])
-    condition = builder.icmp_signed(compare_map[node.children[1].nodetype], left_var, right_var)
+        builder.cbranch(condition, loop_body_block, loop_end_block)
 
-    builder.cbranch(condition, loop_body_block, loop_end_block)
+        builder.position_at_end(loop_body_block)
 
-    builder.position_at_end(loop_body_block)
-    codegen(node.children[3])
-    codegen(node.children[2])
-    builder.branch(loop_cond_block)
-    builder.position_at_end(loop_end_block)
+    def end():
+        builder.branch(loop_cond_block)
+        builder.position_at_end(loop_end_block)
+
+    # initialization, condition, body, update
+    return [node.children[0], condition, node.children[3], node.children[2], end]
 
 def codegen_handler_while_loop(node):
     compare_map = {
@@ -656,16 +761,21 @@ def codegen_handler_while_loop(node):
     builder.cbranch(condition, loop_body_block, loop_end_block)
 
     builder.position_at_end(loop_body_block)
-    codegen(node.children[1])
-    builder.branch(loop_cond_block)
 
-    builder.position_at_end(loop_end_block)
+    def end():
+        builder.branch(loop_cond_block)
+        builder.position_at_end(loop_end_block)
+
+    return [node.children[1], end]
 
 
 def semantic_analysis(node):
     """
     Perform semantic analysis on the root_node of AST
 
+    The tree is walked with an explicit work stack (see walk): every handler returns the children
+    to analyze and the callables to run between them, in left-to-right order
+
     Args:
         node(TreeNode)
 
@@ -694,11 +804,7 @@ def semantic_analysis(node):
         NodeType.FOR_LOOP:semantic_handler_if_else_for_while_stmt,
         NodeType.WHILE_LOOP:semantic_handler_if_else_for_while_stmt
     }
-    handler = handler_map.get(node.nodetype)
-    if handler:
-        handler(node)
-    else:
-        default_handler(node)
+    walk(node, handler_map, default_handler)
     return node.datatype
 
 def semantic_handler_program(node):
@@ -712,16 +818,13 @@ def semantic_handler_program(node):
     symbol_table.insert("print_string", DataType.VOID)
     symbol_table.insert("print_int", DataType.VOID)
     symbol_table.insert("print_bool", DataType.BOOL)
-    # recursively do semantic analysis in left-to-right order for all children nodes
-    for child in node.children:
-        semantic_analysis(child)
-    symbol_table.pop_scope()
+    # do semantic analysis in left-to-right order for all children nodes
+    return node.children + [symbol_table.pop_scope]
 
 # Some Sample handler functions
 # TODO: define more handler functions for various node types
 def default_handler(node):
-    for child in node.children:
-        semantic_analysis(child)
+    return node.children
 
 def semantic_handler_id(node):
     if symbol_table.lookup_global(node.lexeme) is None:
@@ -741,58 +844,55 @@ def semantic_handler_string(node):
 
 # More add handler function
 def semantic_handler_funct_decl(node):
-    semantic_analysis(node.children[0])
-    symbol_table.insert(node.children[1].lexeme, node.children[0].datatype)
-    symbol_table.push_scope()
-    for i in range(1, len(node.children)):
-        semantic_analysis(node.children[i])
-    symbol_table.pop_scope()
+    def declare():
+        symbol_table.insert(node.children[1].lexeme, node.children[0].datatype)
+        symbol_table.push_scope()
+    return [node.children[0], declare] + node.children[1:] + [symbol_table.pop_scope]
     
 def semantic_handler_var_decl(node):
-    semantic_analysis(node.children[1])
-    symbol_table.insert(node.children[0].lexeme, node.children[1].datatype)
-    semantic_analysis(node.children[0])
+    declare = lambda: symbol_table.insert(node.children[0].lexeme, node.children[1].datatype)
+    return [node.children[1], declare, node.children[0]]
 
 def semantic_handler_global_decl(node):
-    semantic_analysis(node.children[1])
-    symbol_table.insert(node.children[0].lexeme, node.children[1].datatype)
-    semantic_analysis(node.children[0])    
+    declare = lambda: symbol_table.insert(node.children[0].lexeme, node.children[1].datatype)
+    return [node.children[1], declare, node.children[0]]
 
 def semantic_handler_return(node):
-    semantic_analysis(node.children[0])
-    node.datatype = node.children[0].datatype
+    def set_datatype():
+        node.datatype = node.children[0].datatype
+    return [node.children[0], set_datatype]
 
 def semantic_handler_args(node):
     node.datatype = DataType.VOID
-    default_handler(node)
+    return default_handler(node)
 
 def semantic_handler_stmts(node):
     node.datatype = DataType.INT
-    default_handler(node)
+    return default_handler(node)
 
 def semantic_handler_if_else_for_while_stmt(node):
     symbol_table.push_scope()
-    for child in node.children:
-        semantic_analysis(child)
-    symbol_table.pop_scope()
+    return node.children + [symbol_table.pop_scope]
 
 
 
 
 if len(sys.argv) == 3:
     # visualize AST before semantic analysis
-    dot_path = sys.argv[1]
+    ast_path = sys.argv[1]
     ast_png_before_semantic_analysis = sys.argv[2]
-    root_node = construct_tree_from_dot(dot_path)
+    root_node, _ = construct_tree(ast_path)
     if DEBUG: print_tree(root_node)
     visualize_tree(root_node, ast_png_before_semantic_analysis)
 elif len(sys.argv) == 4:
     # visualize AST after semantic analysis
-    dot_path = sys.argv[1]
+    ast_path = sys.argv[1]
     ast_png_after_semantics_analysis = sys.argv[2]
     llvm_ir = sys.argv[3]
-    root_node = construct_tree_from_dot(dot_path)
-    semantic_analysis(root_node)
+    root_node, analyzed = construct_tree(ast_path, with_semantics=True)
+    # the C++ frontend has already resolved names and types unless its semantic analysis failed
+    if not analyzed:
+        semantic_analysis(root_node)
     visualize_tree(root_node, ast_png_after_semantics_analysis)
     # Uncomment the following when you are trying the do IR generation
     # init llvm
@@ -807,4 +907,4 @@ elif len(sys.argv) == 4:
     # # print LLVM IR
     # print(module)
 else:
-    raise SyntaxError("Usage: python3 a4.py <.dot> <.png before>\nUsage: python3 ./a4.py <.dot> <.png after> <.ll>")
+    raise SyntaxError("Usage: python3 a4.py <.ast|.dot> <.png before>\nUsage: python3 ./a4.py <.ast|.dot> <.png after> <.ll>")
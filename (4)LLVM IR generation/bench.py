@@ -0,0 +1,97 @@
+# CUHK-SZ CSC4180: Compiler Construction
+# Assignment 4: Oat v.1 Compiler Frontend
+# Author: HaoLUO
+# Date: October 24th, 2026
+#
+# Scaling benchmark of the Oat compiler: generates programs of growing size with gen_oat.py and measures
+# the time and peak memory of every step against the input size:
+#   front    ./compiler to .ast only: scanning, parsing, semantic analysis
+#   ir       ./compiler to .ll: the same plus IR generation
+#   llc      llc -O2 of the IR to an object file
+#
+# Usage: python3 bench.py [--param statements] [--sizes 100,1000,10000] [--output bench]
+#   writes <output>.csv, and <output>.png when matplotlib is installed
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+def run(command):
+    """
+    @return (wall ms, peak RSS KiB) of a command, its output is discarded
+    """
+    start = time.monotonic()
+    process = subprocess.Popen(command, stdout=subprocess.DEVNULL)
+    _, status, usage = os.wait4(process.pid, 0)
+    wall_ms = (time.monotonic() - start) * 1000
+    if status != 0:
+        raise RuntimeError("failed: " + " ".join(command))
+    return wall_ms, usage.ru_maxrss
+
+def plot(rows, param, steps, output):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print("matplotlib is not installed, no plot")
+        return
+    figure, (time_axis, memory_axis) = plt.subplots(1, 2, figsize=(12, 5))
+    for step in steps:
+        time_axis.plot([row["size"] for row in rows], [row[step + "_ms"] for row in rows], marker="o", label=step)
+        memory_axis.plot([row["size"] for row in rows], [row[step + "_rss_kb"] for row in rows], marker="o",
+                         label=step)
+    for axis, title in ((time_axis, "wall time (ms)"), (memory_axis, "peak RSS (KiB)")):
+        axis.set_xscale("log")
+        axis.set_yscale("log")
+        axis.set_xlabel(param)
+        axis.set_title(title)
+        axis.legend()
+    figure.tight_layout()
+    figure.savefig(output + ".png")
+    print("plot written to " + output + ".png")
+
+def main():
+    parser = argparse.ArgumentParser(description="Sweep program sizes and measure every step of compilation")
+    parser.add_argument("--compiler", default=os.path.join(HERE, "compiler"))
+    parser.add_argument("--param", default="statements",
+                        choices=["statements", "functions", "variables", "globals", "arrays", "depth", "nesting"],
+                        help="the generator option to sweep, the others keep their defaults")
+    parser.add_argument("--sizes", default="100,300,1000,3000,10000", help="values of the swept option")
+    parser.add_argument("--output", default="bench", help="prefix of the .csv and .png files")
+    args = parser.parse_args()
+    sizes = [int(size) for size in args.sizes.split(",")]
+    steps = ["front", "ir", "llc"]
+    rows = []
+    with tempfile.TemporaryDirectory() as directory:
+        for size in sizes:
+            stem = os.path.join(directory, "bench%d" % size)
+            subprocess.run([sys.executable, os.path.join(HERE, "gen_oat.py"), "--" + args.param, str(size),
+                            stem + ".oat"], check=True)
+            row = {"size": size, "bytes": os.path.getsize(stem + ".oat")}
+            commands = {
+                "front": [args.compiler, stem + ".oat", stem + ".ast"],
+                "ir": [args.compiler, stem + ".oat", stem + ".ll"],
+                "llc": ["llc", "-O2", "-relocation-model=pic", "-filetype=obj", stem + ".ll", "-o", stem + ".o"],
+            }
+            for step in steps:
+                row[step + "_ms"], row[step + "_rss_kb"] = run(commands[step])
+            rows.append(row)
+            print("%s=%-8d %10d bytes  " % (args.param, size, row["bytes"])
+                  + "  ".join("%s %.1f ms %d KiB" % (step, row[step + "_ms"], row[step + "_rss_kb"])
+                              for step in steps))
+    columns = ["size", "bytes"] + [step + suffix for step in steps for suffix in ("_ms", "_rss_kb")]
+    with open(args.output + ".csv", "w") as file:
+        file.write(",".join(columns) + "\n")
+        for row in rows:
+            file.write(",".join(str(row[column]) for column in columns) + "\n")
+    print("table written to " + args.output + ".csv")
+    plot(rows, args.param, steps, args.output)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,68 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file implements the flattening of a Node tree into the FlatAst defined in flat_ast.hpp
+ */
+
+#include "flat_ast.hpp"
+
+#include <unordered_map>
+
+const uint32_t FlatAst::NONE;
+
+FlatAst::FlatAst(Node* root) {
+    if (root == nullptr) return;
+    std::unordered_map<std::string, uint32_t> string_offsets;    // lexeme -> offset in strings
+    // Explicit stack of the nodes whose children are being added, so the depth of the tree is only
+    // bounded by memory; last_child is where the next child gets linked in
+    struct Frame {
+        Node* node;
+        uint32_t index;
+        size_t next_child;
+        uint32_t last_child;
+    };
+    std::vector<Frame> stack;
+    auto add = [&](Node* node) {
+        uint32_t index = size();
+        uint32_t offset = 0;
+        if (!node->lexeme.empty()) {
+            auto inserted = string_offsets.emplace(node->lexeme, strings.size());
+            if (inserted.second) strings += node->lexeme;
+            offset = inserted.first->second;
+        }
+        symbol_class.push_back(node->symbol_class);
+        datatype.push_back(node->datatype);
+        scope_id.push_back(node->scope_id);
+        lexeme_offset.push_back(offset);
+        lexeme_length.push_back(node->lexeme.size());
+        first_child.push_back(NONE);
+        next_sibling.push_back(NONE);
+        subtree_end.push_back(NONE);
+        if (!stack.empty()) {
+            Frame &parent = stack.back();
+            if (parent.last_child == NONE) {
+                first_child[parent.index] = index;
+            } else {
+                next_sibling[parent.last_child] = index;
+            }
+            parent.last_child = index;
+        }
+        stack.push_back({node, index, 0, NONE});
+    };
+    add(root);
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        if (frame.next_child < frame.node->children.size()) {
+            Node* child = frame.node->children[frame.next_child++];
+            if (child != nullptr) add(child);
+            continue;
+        }
+        subtree_end[frame.index] = size();
+        stack.pop_back();
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file defines the struct-of-arrays form of the AST, which the .dot and .ast exporters walk instead of Node pointers.
+ */
+
+#ifndef CSC4180_FLAT_AST_HPP
+#define CSC4180_FLAT_AST_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "node.hpp"
+
+/**
+ * AST as parallel arrays, one entry per node, built once from the Node tree after semantic analysis
+ *
+ * Nodes are numbered in pre-order (the node ids of the .dot file and the record order of the .ast file), so the
+ * subtree of node i is the index range [i, subtree_end[i]) and an export is a forward scan through contiguous memory.
+ * Lexemes are spans of one string table holding every distinct lexeme once, in order of first appearance,
+ * which is the string table of the .ast format as is.
+ */
+struct FlatAst {
+    static const uint32_t NONE = UINT32_MAX;
+
+    std::vector<SymbolClass> symbol_class;
+    std::vector<DataType> datatype;
+    std::vector<uint32_t> scope_id;
+    std::vector<uint32_t> lexeme_offset;    // offset in strings, 0 for an empty lexeme
+    std::vector<uint32_t> lexeme_length;
+    std::vector<uint32_t> first_child;      // NONE for leaves, i + 1 otherwise
+    std::vector<uint32_t> next_sibling;     // NONE for the last child
+    std::vector<uint32_t> subtree_end;      // one past the last node of the subtree
+
+    std::string strings;
+
+    FlatAst() = default;
+
+    /**
+     * Flatten a tree in pre-order, null children (absent optional parts) are left out
+     * @param root: root of the Node tree, may be null for an empty program
+     */
+    explicit FlatAst(Node* root);
+
+    size_t size() const { return symbol_class.size(); }
+    bool empty() const { return symbol_class.empty(); }
+
+    /**
+     * @return the number of children of a node, counted through the sibling links
+     */
+    uint32_t child_count(uint32_t index) const {
+        uint32_t count = 0;
+        for (uint32_t child = first_child[index]; child != NONE; child = next_sibling[child]) ++count;
+        return count;
+    }
+};
+
+#endif  // CSC4180_FLAT_AST_HPP
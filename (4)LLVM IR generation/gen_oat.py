@@ -0,0 +1,350 @@
+# CUHK-SZ CSC4180: Compiler Construction
+# Assignment 4: Oat v.1 Compiler Frontend
+# Author: HaoLUO
+# Date: October 24th, 2026
+#
+# Generator of large valid Oat v.1 programs for stress tests and scaling benchmarks.
+# The program is built as a small tree, printed as Oat, and run by a reference interpreter with the i32
+# semantics of the generated LLVM IR, which gives its expected output.
+#
+# Usage: python3 gen_oat.py [options] program.oat
+#   writes program.oat and its expected output (--expected, default <program>-expected.txt)
+
+import argparse
+import random
+import sys
+
+ARRAY_LENGTH = 8        # indices are masked with [&] 7, so every access is in bounds
+MAX_TRIPS = 3           # iterations of a generated loop
+CALL_BUDGET = 2000      # estimated steps a call may cost where it is placed, keeps the run time bounded
+
+def wrap(value):
+    """
+    @return value as a two's complement i32
+    """
+    value &= 0xFFFFFFFF
+    return value - (1 << 32) if value & 0x80000000 else value
+
+class Function:
+    def __init__(self, name, params):
+        self.name = name
+        self.params = params
+        self.locals = []        # [(name, initializer)]
+        self.arrays = []        # local int[ARRAY_LENGTH] names
+        self.body = []
+        self.result = None      # returned expression
+        self.cost = 0           # estimated steps of one call
+
+class Generator:
+    """
+    Builds the tree of an Oat program
+
+    Expressions: ('lit', n) ('var', name) ('index', array, e) ('bin', op, l, r) ('neg', e) ('bnot', e)
+                 ('call', function, [e])
+    Conditions:  ('cmp', op, l, r) ('and', c, c) ('or', c, c) ('not', c)
+    Statements:  ('assign', name, e) ('store', array, index, e) ('print', e) ('newline',)
+                 ('if', c, [s], [s]) ('for', counter, trips, [s]) ('while', counter, trips, [s])
+    Functions only read globals, so no expression has side effects and the evaluation order does not matter.
+    """
+    def __init__(self, rng, args):
+        self.rng = rng
+        self.args = args
+        self.globals = ["g%d" % i for i in range(args.globals)]
+        self.functions = []
+        self.function = None        # function being generated
+        self.variables = []         # int variables assignable in the current function
+        self.readable = []          # int variables readable in the current function
+        self.counter_id = 0
+        self.multiplier = 1         # iterations of the enclosing loops
+
+    def literal(self):
+        if self.rng.random() < 0.05:
+            return ('lit', self.rng.randint(0, 2 ** 31 - 1))
+        return ('lit', self.rng.randint(0, 1000))
+
+    def expression(self, depth):
+        choice = self.rng.random()
+        if depth <= 0 or choice < 0.25:
+            choice = self.rng.random()
+            if choice < 0.55 and self.readable:
+                return ('var', self.rng.choice(self.readable))
+            if choice < 0.7 and self.function.arrays:
+                return ('index', self.rng.choice(self.function.arrays), self.expression(depth - 1))
+            return self.literal()
+        if choice < 0.32:
+            return (self.rng.choice(['neg', 'bnot']), self.expression(depth - 1))
+        if choice < 0.36:
+            callees = [f for f in self.functions if f.cost * self.multiplier <= CALL_BUDGET]
+            if callees:
+                callee = self.rng.choice(callees)
+                return ('call', callee, [self.expression(depth - 1) for _ in callee.params])
+        op = self.rng.choice(['+', '+', '-', '-', '*', '<<', '>>', '>>>', '[&]', '[|]'])
+        if op in ('<<', '>>', '>>>'):
+            # a shift by 32 or more is poison in LLVM, shift by literals below 32 only
+            return ('bin', op, self.expression(depth - 1), ('lit', self.rng.randint(0, 31)))
+        return ('bin', op, self.expression(depth - 1), self.expression(depth - 1))
+
+    def condition(self, depth):
+        choice = self.rng.random()
+        if depth > 0 and choice < 0.15:
+            return ('and', self.condition(depth - 1), self.condition(depth - 1))
+        if depth > 0 and choice < 0.3:
+            return ('or', self.condition(depth - 1), self.condition(depth - 1))
+        if depth > 0 and choice < 0.35:
+            return ('not', self.condition(depth - 1))
+        op = self.rng.choice(['<', '<=', '>', '>=', '==', '!='])
+        return ('cmp', op, self.expression(self.args.depth // 2), self.expression(self.args.depth // 2))
+
+    def block(self, count, nesting):
+        statements = []
+        while len(statements) < count:
+            choice = self.rng.random()
+            remaining = count - len(statements)
+            if nesting > 0 and remaining > 2 and choice < 0.15:
+                inner = self.rng.randint(1, min(remaining - 1, 8))
+                kind = self.rng.choice(['if', 'for', 'while'])
+                if kind == 'if':
+                    statements.append(('if', self.condition(2), self.block(inner, nesting - 1),
+                                       self.block(self.rng.randint(0, inner), nesting - 1)))
+                else:
+                    self.counter_id += 1
+                    counter = "i%d" % self.counter_id
+                    trips = self.rng.randint(0, MAX_TRIPS)
+                    self.multiplier *= max(1, trips)
+                    # the counter is readable in the body, never assigned by it
+                    self.readable.append(counter)
+                    body = self.block(inner, nesting - 1)
+                    self.readable.pop()
+                    self.multiplier //= max(1, trips)
+                    statements.append((kind, counter, trips, body))
+            elif choice < 0.3 and self.function.arrays:
+                statements.append(('store', self.rng.choice(self.function.arrays),
+                                   self.expression(1), self.expression(self.args.depth)))
+            elif choice < 0.45 and self.function.name == "main":
+                statements.append(('print', self.expression(self.args.depth)))
+                if self.rng.random() < 0.3:
+                    statements.append(('newline',))
+            else:
+                statements.append(('assign', self.rng.choice(self.variables), self.expression(self.args.depth)))
+        return statements
+
+    def generate_function(self, name, num_params, num_statements):
+        function = Function(name, ["p%d" % i for i in range(num_params)])
+        self.function = function
+        self.readable = self.globals + function.params
+        self.variables = list(function.params)
+        for i in range(self.args.variables):
+            function.locals.append(("v%d" % i, self.expression(1)))
+            self.readable.append("v%d" % i)
+            self.variables.append("v%d" % i)
+        function.arrays = ["a%d" % i for i in range(self.args.arrays)]
+        if name == "main":
+            # only main assigns globals, functions stay free of side effects
+            self.variables += self.globals
+        function.body = self.block(num_statements, self.args.nesting)
+        function.result = self.expression(self.args.depth) if name != "main" else ('lit', 0)
+        function.cost = statements_cost(function.body) + expression_cost(function.result) + len(function.locals)
+        return function
+
+    def program(self):
+        per_function = max(1, self.args.statements // (self.args.functions + 1))
+        for i in range(self.args.functions):
+            self.functions.append(self.generate_function("f%d" % i, self.rng.randint(0, 3), per_function))
+        self.main = self.generate_function("main", 0, per_function)
+        self.global_values = [self.rng.randint(0, 1000) for _ in self.globals]
+
+def expression_cost(e):
+    kind = e[0]
+    if kind in ('lit', 'var'):
+        return 1
+    if kind == 'call':
+        return 1 + e[1].cost + sum(expression_cost(a) for a in e[2])
+    return 1 + sum(expression_cost(child) for child in e[1:] if isinstance(child, tuple))
+
+def statements_cost(statements):
+    cost = 0
+    for s in statements:
+        kind = s[0]
+        if kind == 'if':
+            cost += expression_cost(s[1]) + max(statements_cost(s[2]), statements_cost(s[3]))
+        elif kind in ('for', 'while'):
+            cost += (s[2] + 1) * (statements_cost(s[3]) + 2)
+        else:
+            cost += 1 + sum(expression_cost(child) for child in s[1:] if isinstance(child, tuple))
+    return cost
+
+# ------------------------------------------------------------------------------------------------------------
+# Printing
+
+def expression_text(e):
+    kind = e[0]
+    if kind == 'lit':
+        return str(e[1])
+    if kind == 'var':
+        return e[1]
+    if kind == 'index':
+        return "%s[(%s [&] %d)]" % (e[1], expression_text(e[2]), ARRAY_LENGTH - 1)
+    if kind == 'neg':
+        return "-" + expression_text(e[1])
+    if kind == 'bnot':
+        return "~" + expression_text(e[1])
+    if kind == 'call':
+        return "%s(%s)" % (e[1].name, ", ".join(expression_text(a) for a in e[2]))
+    if kind == 'cmp' or kind == 'bin':
+        return "(%s %s %s)" % (expression_text(e[2]), e[1], expression_text(e[3]))
+    if kind == 'and' or kind == 'or':
+        return "(%s %s %s)" % (expression_text(e[1]), '&' if kind == 'and' else '|', expression_text(e[2]))
+    if kind == 'not':
+        return "!" + expression_text(e[1])
+    raise ValueError(kind)
+
+def statements_text(statements, indent, lines):
+    pad = "    " * indent
+    for s in statements:
+        kind = s[0]
+        if kind == 'assign':
+            lines.append("%s%s = %s;" % (pad, s[1], expression_text(s[2])))
+        elif kind == 'store':
+            lines.append("%s%s[(%s [&] %d)] = %s;" % (pad, s[1], expression_text(s[2]), ARRAY_LENGTH - 1,
+                                                      expression_text(s[3])))
+        elif kind == 'print':
+            lines.append("%sprint_int(%s);" % (pad, expression_text(s[1])))
+            lines.append('%sprint_string(" ");' % pad)
+        elif kind == 'newline':
+            lines.append('%sprint_string("\\n");' % pad)
+        elif kind == 'if':
+            lines.append("%sif (%s) {" % (pad, expression_text(s[1])))
+            statements_text(s[2], indent + 1, lines)
+            if s[3]:
+                lines.append("%s} else {" % pad)
+                statements_text(s[3], indent + 1, lines)
+            lines.append("%s}" % pad)
+        elif kind == 'for':
+            lines.append("%sfor (var %s = 0; %s < %d; %s = %s + 1;) {" % (pad, s[1], s[1], s[2], s[1], s[1]))
+            statements_text(s[3], indent + 1, lines)
+            lines.append("%s}" % pad)
+        elif kind == 'while':
+            lines.append("%svar %s = %d;" % (pad, s[1], s[2]))
+            lines.append("%swhile (%s > 0) {" % (pad, s[1]))
+            statements_text(s[3], indent + 1, lines)
+            lines.append("%s    %s = %s - 1;" % (pad, s[1], s[1]))
+            lines.append("%s}" % pad)
+
+def program_text(generator):
+    lines = []
+    for name, value in zip(generator.globals, generator.global_values):
+        lines.append("global %s = %d;" % (name, value))
+    for function in generator.functions + [generator.main]:
+        params = ", ".join("int " + p for p in function.params)
+        lines.append("int %s(%s) {" % (function.name, params))
+        for name, initializer in function.locals:
+            lines.append("    var %s = %s;" % (name, expression_text(initializer)))
+        for array in function.arrays:
+            lines.append("    var %s = new int[%d];" % (array, ARRAY_LENGTH))
+        statements_text(function.body, 1, lines)
+        lines.append("    return %s;" % expression_text(function.result))
+        lines.append("}")
+    return "\n".join(lines) + "\n"
+
+# ------------------------------------------------------------------------------------------------------------
+# Reference interpreter
+
+class Interpreter:
+    def __init__(self, generator):
+        self.globals = dict(zip(generator.globals, generator.global_values))
+        self.output = []
+
+    def value(self, e, env):
+        kind = e[0]
+        if kind == 'lit':
+            return e[1]
+        if kind == 'var':
+            return env[e[1]] if e[1] in env else self.globals[e[1]]
+        if kind == 'index':
+            return env[e[1]][self.value(e[2], env) & (ARRAY_LENGTH - 1)]
+        if kind == 'neg':
+            return wrap(-self.value(e[1], env))
+        if kind == 'bnot':
+            return wrap(~self.value(e[1], env))
+        if kind == 'call':
+            return self.call(e[1], [self.value(a, env) for a in e[2]])
+        if kind == 'bin':
+            op, l, r = e[1], self.value(e[2], env), self.value(e[3], env)
+            if op == '+': return wrap(l + r)
+            if op == '-': return wrap(l - r)
+            if op == '*': return wrap(l * r)
+            if op == '<<': return wrap(l << r)
+            if op == '>>': return wrap((l & 0xFFFFFFFF) >> r)     # logical
+            if op == '>>>': return l >> r                           # arithmetic
+            if op == '[&]': return wrap(l & r)
+            if op == '[|]': return wrap(l | r)
+        if kind == 'cmp':
+            op, l, r = e[1], self.value(e[2], env), self.value(e[3], env)
+            return {'<': l < r, '<=': l <= r, '>': l > r, '>=': l >= r, '==': l == r, '!=': l != r}[op]
+        if kind == 'and':
+            return self.value(e[1], env) and self.value(e[2], env)
+        if kind == 'or':
+            return self.value(e[1], env) or self.value(e[2], env)
+        if kind == 'not':
+            return not self.value(e[1], env)
+        raise ValueError(kind)
+
+    def assign(self, name, value, env):
+        if name in env:
+            env[name] = value
+        else:
+            self.globals[name] = value
+
+    def run(self, statements, env):
+        for s in statements:
+            kind = s[0]
+            if kind == 'assign':
+                self.assign(s[1], self.value(s[2], env), env)
+            elif kind == 'store':
+                env[s[1]][self.value(s[2], env) & (ARRAY_LENGTH - 1)] = self.value(s[3], env)
+            elif kind == 'print':
+                self.output.append("%d " % self.value(s[1], env))
+            elif kind == 'newline':
+                self.output.append("\n")
+            elif kind == 'if':
+                self.run(s[2] if self.value(s[1], env) else s[3], env)
+            else:
+                for i in range(s[2]):
+                    env[s[1]] = i if kind == 'for' else s[2] - i
+                    self.run(s[3], env)
+
+    def call(self, function, arguments):
+        env = dict(zip(function.params, arguments))
+        for name, initializer in function.locals:
+            env[name] = self.value(initializer, env)
+        for array in function.arrays:
+            env[array] = [0] * ARRAY_LENGTH
+        self.run(function.body, env)
+        return self.value(function.result, env)
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a valid Oat v.1 program with its expected output")
+    parser.add_argument("program", help="the .oat file to write")
+    parser.add_argument("-n", "--statements", type=int, default=100, help="number of statements over all functions")
+    parser.add_argument("-f", "--functions", type=int, default=4, help="number of functions besides main")
+    parser.add_argument("-v", "--variables", type=int, default=8, help="number of local int variables per function")
+    parser.add_argument("-g", "--globals", type=int, default=4, help="number of global int variables")
+    parser.add_argument("-a", "--arrays", type=int, default=1, help="number of local int arrays per function")
+    parser.add_argument("-d", "--depth", type=int, default=3, help="maximum expression depth")
+    parser.add_argument("-k", "--nesting", type=int, default=3, help="maximum nesting of if/for/while blocks")
+    parser.add_argument("-s", "--seed", type=int, default=4180, help="random seed, the same seed gives the same program")
+    parser.add_argument("--expected", help="[Default: <program>-expected.txt] expected output")
+    args = parser.parse_args()
+    sys.setrecursionlimit(100000)
+    generator = Generator(random.Random(args.seed), args)
+    generator.program()
+    stem = args.program[:-4] if args.program.endswith(".oat") else args.program
+    with open(args.program, "w") as file:
+        file.write(program_text(generator))
+    interpreter = Interpreter(generator)
+    interpreter.call(generator.main, [])
+    with open(args.expected or stem + "-expected.txt", "w") as file:
+        file.write("".join(interpreter.output))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,391 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file implements the incremental parser defined in incremental_parser.hpp
+ */
+
+#include "incremental_parser.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
+#include "parser.hpp"
+
+// defined in scanner.l
+extern int yylex();
+extern int yyleng;
+extern size_t scan_offset;
+extern bool scan_reached_end;
+void begin_buffer_scan(char* text, size_t length);     // text must be followed by two NULs
+void end_buffer_scan();
+
+// defined in parser.y
+extern int (*token_source)();
+extern Node* root_node;
+extern int yyparse();
+
+// the run of tokens yyparse pulls through token_source while items are parsed again
+static const IncrementalParser::Token* replay_next = nullptr;
+static const IncrementalParser::Token* replay_end = nullptr;
+static const char* replay_text = nullptr;
+static bool replay_scaneof = false;
+static std::deque<std::string> replay_strings;    // lexemes of ID and STRINGLITERAL, the parser copies them
+
+/**
+ * Hand the next recorded token to the parser, with its semantic value rebuilt from the text as the scanner does
+ * @return token number, SCANEOF after the run and 0 after that, like the scanner at the end of its input
+ */
+static int replay_token() {
+    if (replay_next == replay_end) {
+        if (replay_scaneof) return 0;
+        replay_scaneof = true;
+        return SCANEOF;
+    }
+    const IncrementalParser::Token &token = *replay_next++;
+    const char* lexeme = replay_text + token.start;
+    if (token.kind == ID || token.kind == STRINGLITERAL) {
+        replay_strings.emplace_back(lexeme, token.end - token.start);
+        yylval.string = &replay_strings.back();
+    } else if (token.kind == INTLITERAL) {
+        yylval.integer = std::atoi(lexeme);
+    }
+    return token.kind;
+}
+
+/**
+ * Delete a subtree, with an explicit stack so the depth of the tree is only bounded by memory
+ */
+static void delete_tree(Node* node) {
+    std::vector<Node*> stack;
+    if (node != nullptr) stack.push_back(node);
+    while (!stack.empty()) {
+        Node* top = stack.back();
+        stack.pop_back();
+        for (Node* child : top->children)
+            if (child != nullptr) stack.push_back(child);
+        delete top;
+    }
+}
+
+IncrementalParser::~IncrementalParser() {
+    for (auto &item : items)
+        for (Node* decl : item.decls) delete_tree(decl);
+    delete root;
+}
+
+/**
+ * @return length of the common prefix of two texts of at least n characters
+ */
+static size_t common_prefix(const char* a, const char* b, size_t n) {
+    // whole blocks with memcmp first, which is far faster than a character loop
+    size_t i = 0;
+    while (i + 4096 <= n && std::memcmp(a + i, b + i, 4096) == 0) i += 4096;
+    while (i < n && a[i] == b[i]) ++i;
+    return i;
+}
+
+/**
+ * @return length of the common suffix of two texts ending at a_end and b_end, at most n characters
+ */
+static size_t common_suffix(const char* a_end, const char* b_end, size_t n) {
+    size_t i = 0;
+    while (i + 4096 <= n && std::memcmp(a_end - i - 4096, b_end - i - 4096, 4096) == 0) i += 4096;
+    while (i < n && a_end[-1 - (long)i] == b_end[-1 - (long)i]) ++i;
+    return i;
+}
+
+IncrementalParser::Token IncrementalParser::token(size_t index) const {
+    if (index < gap_start) return token_buffer[index];
+    Token token = token_buffer[index + (gap_end - gap_start)];
+    token.start = length - token.start;
+    token.end = length - token.end;
+    return token;
+}
+
+void IncrementalParser::move_gap(size_t index) {
+    // an offset x is length - x in the other form and back
+    while (gap_start > index) {
+        Token &token = token_buffer[--gap_end] = token_buffer[--gap_start];
+        token.start = length - token.start;
+        token.end = length - token.end;
+    }
+    while (gap_start < index) {
+        Token &token = token_buffer[gap_start++] = token_buffer[gap_end++];
+        token.start = length - token.start;
+        token.end = length - token.end;
+    }
+}
+
+void IncrementalParser::replace_tokens(size_t first, size_t end, const std::vector<Token>& fresh) {
+    gap_end += end - first;
+    if (fresh.size() > gap_end - gap_start) {
+        // grow with a gap of an eighth of the tokens, so growing is amortized over the edits
+        size_t after = token_buffer.size() - gap_end;
+        size_t gap = fresh.size() + std::max<size_t>(1024, token_count() / 8);
+        std::vector<Token> grown(gap_start + gap + after);
+        std::copy(token_buffer.begin(), token_buffer.begin() + gap_start, grown.begin());
+        std::copy(token_buffer.begin() + gap_end, token_buffer.end(), grown.end() - after);
+        token_buffer.swap(grown);
+        gap_end = gap_start + gap;
+    }
+    std::copy(fresh.begin(), fresh.end(), token_buffer.begin() + gap_start);
+    gap_start += fresh.size();
+}
+
+Node* IncrementalParser::update(const std::string& source) {
+    last_stats = Stats();
+    // the edit is what lies between the common prefix and the common suffix of the two versions
+    size_t new_length = source.size();
+    size_t prefix = 0;
+    size_t suffix = 0;
+    if (started) {
+        size_t shorter = std::min(length, new_length);
+        prefix = common_prefix(source.data(), text.data(), shorter);
+        if (prefix == length && prefix == new_length) {
+            last_stats.tokens = token_count();
+            last_stats.items = items.size();
+            return root;
+        }
+        suffix = common_suffix(source.data() + new_length, text.data() + length, shorter - prefix);
+    }
+
+    // the first token the scanner read edited text for: it reads at most two characters past the end of a token,
+    // or up to the end of the input for an unclosed string or comment
+    size_t first = 0;
+    size_t last = token_count();
+    while (first < last) {
+        size_t middle = first + (last - first) / 2;
+        if (token(middle).end + 2 <= prefix) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    if (!reached_end_tokens.empty()) first = std::min<size_t>(first, reached_end_tokens.front());
+    size_t from = first == 0 ? 0 : token(first - 1).end;
+
+    // the tokens after the gap keep their offsets from the end through the change of text
+    move_gap(first);
+    text.assign(source);
+    text.append(2, '\0');
+    length = new_length;
+    started = true;
+
+    std::vector<Token> fresh;
+    size_t old_end = rescan(from, first, new_length - suffix, fresh);
+    replace_tokens(first, old_end, fresh);
+    last_stats.rescanned_tokens = fresh.size();
+    long token_delta = (long)fresh.size() - (long)(old_end - first);
+    std::vector<uint32_t> reached_end;
+    for (size_t i = 0; i < fresh.size(); ++i)
+        if (fresh[i].reached_end) reached_end.push_back(first + i);
+    for (uint32_t index : reached_end_tokens)
+        if (index >= old_end) reached_end.push_back(index + token_delta);
+    reached_end_tokens.swap(reached_end);
+
+    // cut the tokens into items again from the item holding the first new token, until an item ends where an old one
+    // did after the new tokens; items are contiguous from token 0 to SCANEOF
+    size_t first_item = std::partition_point(items.begin(), items.end(), [first](const Item &item) {
+        return item.end <= first;
+    }) - items.begin();
+    uint32_t at = first_item < items.size() ? items[first_item].first : (items.empty() ? 0 : items.back().end);
+    uint32_t scaneof = token_count() - 1;
+    size_t fresh_end = first + fresh.size();
+    std::vector<Item> fresh_items;
+    size_t old_item = first_item;
+    size_t kept_item = items.size();
+    while (at < scaneof) {
+        uint32_t end = item_end(at);
+        fresh_items.push_back({at, end, false, false, {}});
+        at = end;
+        if (end < fresh_end) continue;
+        while (old_item < items.size() && (long)items[old_item].end + token_delta < (long)end) ++old_item;
+        if (old_item < items.size() && (long)items[old_item].end + token_delta == (long)end &&
+            items[old_item].end >= old_end) {
+            kept_item = old_item + 1;
+            break;
+        }
+    }
+    for (size_t i = first_item; i < kept_item; ++i)
+        for (Node* decl : items[i].decls) delete_tree(decl);
+    items.erase(items.begin() + first_item, items.begin() + kept_item);
+    items.insert(items.begin() + first_item, fresh_items.begin(), fresh_items.end());
+    for (size_t i = first_item + fresh_items.size(); i < items.size(); ++i) {
+        items[i].first += token_delta;
+        items[i].end += token_delta;
+    }
+
+    // parse every run of items without a tree in order, the new ones and those that failed last time;
+    // the first syntax error stops the parse as it stops a full one
+    bool parsed = true;
+    for (size_t i = 0; parsed && i < items.size(); ++i) {
+        if (items[i].parsed) continue;
+        size_t end = i;
+        while (end < items.size() && !items[end].parsed) ++end;
+        parsed = parse_items(i, end, skim);
+    }
+    last_stats.tokens = token_count();
+    last_stats.items = items.size();
+
+    delete root;
+    root = nullptr;
+    if (parsed) rebuild_root();
+    return root;
+}
+
+size_t IncrementalParser::rescan(size_t from, size_t old_first, size_t edit_end, std::vector<Token>& fresh) {
+    size_t old = old_first;
+    size_t old_end = token_count();
+    begin_buffer_scan(&text[from], length - from);
+    for (int kind = yylex(); kind != 0; kind = yylex()) {
+        Token token;
+        token.kind = kind;
+        token.end = from + scan_offset;
+        // the <<EOF>> rule matches no text
+        token.start = kind == SCANEOF ? token.end : token.end - yyleng;
+        token.reached_end = scan_reached_end;
+        scan_reached_end = false;
+        if (kind == ID || kind == STRINGLITERAL) delete yylval.string;
+        fresh.push_back(token);
+        if (kind == SCANEOF) break;
+        if (token.end < edit_end) continue;
+        // past the edit, the old tokens after one ending here are the ones the scan would find from here on;
+        // old tokens past the edit have their offsets in the new text, being counted from the end
+        while (old < old_end && this->token(old).end < token.end) ++old;
+        if (old < old_end && this->token(old).end == token.end && this->token(old).kind != SCANEOF) {
+            old_end = old + 1;
+            break;
+        }
+    }
+    end_buffer_scan();
+    return old_end;
+}
+
+uint32_t IncrementalParser::item_end(uint32_t first) const {
+    bool global = token(first).kind == GLOBAL;
+    long depth = 0;
+    uint32_t scaneof = token_count() - 1;
+    for (uint32_t i = first; i < scaneof; ++i) {
+        int kind = token(i).kind;
+        if (kind == LBRACE) {
+            ++depth;
+        } else if (kind == RBRACE) {
+            if (--depth <= 0 && !global) return i + 1;
+        } else if (kind == SEMICOLON && global && depth == 0) {
+            return i + 1;
+        }
+    }
+    // not closed, the parser reports the error
+    return scaneof;
+}
+
+uint32_t IncrementalParser::body_start(const Item& item) const {
+    // item_end stops at the RBRACE that closes the first LBRACE, unless the braces do not match
+    if (item.end - item.first < 2 || token(item.first).kind == GLOBAL || token(item.end - 1).kind != RBRACE)
+        return item.end;
+    for (uint32_t i = item.first; i < item.end - 1; ++i) {
+        int kind = token(i).kind;
+        if (kind == LBRACE) return i;
+        if (kind == RBRACE) break;
+    }
+    return item.end;
+}
+
+bool IncrementalParser::parse_items(size_t first_item, size_t end_item, bool skim_bodies) {
+    std::vector<Token> run;
+    std::vector<bool> skimmed;
+    for (size_t k = first_item; k < end_item; ++k) {
+        const Item &item = items[k];
+        uint32_t body = skim_bodies ? body_start(item) : item.end;
+        if (body < item.end) {
+            // the header with its LBRACE, then the RBRACE closing the body
+            for (uint32_t i = item.first; i <= body; ++i) run.push_back(token(i));
+            run.push_back(token(item.end - 1));
+        } else {
+            for (uint32_t i = item.first; i < item.end; ++i) run.push_back(token(i));
+        }
+        skimmed.push_back(body < item.end);
+    }
+    replay_next = run.data();
+    replay_end = run.data() + run.size();
+    replay_text = text.data();
+    replay_scaneof = false;
+    token_source = replay_token;
+    root_node = nullptr;
+    bool failed = yyparse() != 0;
+    token_source = yylex;
+    replay_strings.clear();
+    last_stats.reparsed_items += end_item - first_item;
+    if (failed) return false;
+    last_stats.skimmed_items += std::count(skimmed.begin(), skimmed.end(), true);
+
+    for (size_t k = first_item; k < end_item; ++k) {
+        for (Node* decl : items[k].decls) delete_tree(decl);
+        items[k].decls.clear();
+    }
+    std::vector<Node*> decls;
+    if (root_node != nullptr) decls.swap(root_node->children);
+    delete root_node;
+    root_node = nullptr;
+    if (decls.size() == end_item - first_item) {
+        for (size_t i = 0; i < decls.size(); ++i) {
+            items[first_item + i].decls.assign(1, decls[i]);
+            items[first_item + i].parsed = true;
+            items[first_item + i].skimmed = skimmed[i];
+        }
+    } else {
+        // the braces cut the run differently from the grammar: keep the run as one item
+        items[first_item].end = items[end_item - 1].end;
+        items[first_item].decls.swap(decls);
+        items[first_item].parsed = true;
+        items[first_item].skimmed = std::find(skimmed.begin(), skimmed.end(), true) != skimmed.end();
+        items.erase(items.begin() + first_item + 1, items.begin() + end_item);
+    }
+    return true;
+}
+
+Node* IncrementalParser::parse_body(const std::string& name) {
+    if (root == nullptr) return nullptr;
+    for (size_t i = 0; i < items.size(); ++i) {
+        for (Node* decl : items[i].decls) {
+            if (decl->symbol_class != SymbolClass::function_decl || decl->children[1]->lexeme != name) continue;
+            if (!items[i].skimmed) return decl;
+            if (!parse_items(i, i + 1, false)) return nullptr;
+            rebuild_root();
+            for (Node* full : items[i].decls)
+                if (full->symbol_class == SymbolClass::function_decl && full->children[1]->lexeme == name) return full;
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+Node* IncrementalParser::parse_bodies() {
+    if (root == nullptr) return nullptr;
+    bool parsed = true;
+    for (size_t i = 0; parsed && i < items.size(); ++i) {
+        if (!items[i].skimmed) continue;
+        size_t end = i;
+        while (end < items.size() && items[end].skimmed) ++end;
+        parsed = parse_items(i, end, false);
+    }
+    rebuild_root();
+    return parsed ? root : nullptr;
+}
+
+void IncrementalParser::rebuild_root() {
+    // program: %empty gives no root, as in parser.y; a root handed out before stays the same node
+    if (root != nullptr) root->children.clear();
+    for (auto &item : items) {
+        if (item.decls.empty()) continue;
+        if (root == nullptr) root = new Node(SymbolClass::program);
+        for (Node* decl : item.decls) root->append_child(decl);
+    }
+}
@@ -0,0 +1,168 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 24th, 2026
+ *
+ * This file defines the incremental parser, which keeps the tokens and the AST of a source between versions
+ * and re-scans and re-parses only the part an edit touched, for compiler --watch; in skim mode it also leaves out
+ * the bodies of functions until they are needed, for compiler --skim.
+ */
+
+#ifndef CSC4180_INCREMENTAL_PARSER_HPP
+#define CSC4180_INCREMENTAL_PARSER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "node.hpp"
+
+/**
+ * Parser of successive versions of one Oat source
+ *
+ * Re-scanning: the scanner has no start conditions, so it is in its initial state at every token boundary and can
+ * restart at any of them. Each token records how far the scanner read to produce it; an edit re-scans from the end
+ * of the last token that did not read into the edited text, until a new token ends where an old one did past the edit.
+ * Every token from there on is kept. The tokens are a gap buffer with the gap at the last edit, and the ones after the
+ * gap hold offsets counted back from the end of the text, so the kept tokens need no update when the length changes
+ * and an edit only moves the tokens between the gap and itself.
+ *
+ * Re-parsing: the tokens are cut into top-level items, one global_decl (GLOBAL up to its SEMICOLON) or function_decl
+ * (up to the RBRACE closing its body) each, by counting braces. Only the items that hold re-scanned tokens are parsed
+ * again, by replaying their tokens through the bison parser; the subtrees of the other items are kept as they are.
+ * Items that failed to parse are parsed again on the next version, so the tree is always the one a full parse builds.
+ *
+ * Skim mode: a function item is replayed as its header up to the LBRACE of its body followed by the closing RBRACE,
+ * so the parser builds the declaration with an empty body and the tokens in between are only scanned and counted.
+ * The item keeps its token range, parse_body and parse_bodies replay the whole item later when a body is needed.
+ */
+class IncrementalParser {
+public:
+    /**
+     * Work done by the last update, in tokens and top-level items
+     */
+    struct Stats {
+        size_t tokens = 0;
+        size_t rescanned_tokens = 0;
+        size_t items = 0;
+        size_t reparsed_items = 0;
+        size_t skimmed_items = 0;
+    };
+
+    /**
+     * @param skim: leave out the bodies of functions until they are asked for
+     */
+    explicit IncrementalParser(bool skim = false) : skim(skim) {}
+    IncrementalParser(const IncrementalParser&) = delete;
+    IncrementalParser& operator=(const IncrementalParser&) = delete;
+    ~IncrementalParser();
+
+    /**
+     * Parse a new version of the source, the first one is parsed in full
+     * Syntax errors are reported to std::cerr by yyerror, as in a full parse.
+     * @param source: text of the new version
+     * @return root of the AST, null for an empty program or a syntax error; it belongs to the parser and
+     *         stays valid until the next update, kept subtrees keep the data types and scope ids they were given
+     */
+    Node* update(const std::string& source);
+
+    const Stats& stats() const { return last_stats; }
+
+    /**
+     * Parse the body a function was skimmed without, its declaration in the tree is replaced by the full one
+     * @param name: name of the function
+     * @return the full function_decl, which is the one in the tree if it has its body already;
+     *         null if no function has that name or its body has a syntax error
+     */
+    Node* parse_body(const std::string& name);
+
+    /**
+     * Parse every body left out by skim mode, in one replay per run of skimmed functions
+     * @return root of the full AST as update returns it, null on a syntax error
+     */
+    Node* parse_bodies();
+
+    /**
+     * A recorded token, replayed to the parser when its item is parsed again
+     */
+    struct Token {
+        int kind;               // token number of parser.hpp
+        uint32_t start;         // offsets in the text
+        uint32_t end;
+        bool reached_end;       // the scanner read to the end of the input on the way to this token
+    };
+
+private:
+    struct Item {
+        uint32_t first;         // token range [first, end)
+        uint32_t end;
+        bool parsed;
+        bool skimmed;           // parsed with an empty body
+        std::vector<Node*> decls;   // one, or more if the items of a parse did not line up with its declarations
+    };
+
+    size_t token_count() const { return token_buffer.size() - (gap_end - gap_start); }
+
+    /**
+     * @return the token at an index, with its offsets in the current text
+     */
+    Token token(size_t index) const;
+
+    /**
+     * Move the gap of the token buffer before a token, the tokens it passes are converted to the other offset form
+     */
+    void move_gap(size_t index);
+
+    /**
+     * Replace the tokens [first, end) with new ones, the gap must be at first
+     */
+    void replace_tokens(size_t first, size_t end, const std::vector<Token>& fresh);
+
+    /**
+     * Scan the text from an offset until the scan lines up with the old tokens after the edit, or to the end
+     * The old tokens from old_first on must be after the gap.
+     * @param from: offset to start scanning at, a token boundary
+     * @param old_first: index of the first old token that may be replaced
+     * @param edit_end: end of the edited text
+     * @param fresh: the new tokens
+     * @return index one past the last old token replaced by the new ones
+     */
+    size_t rescan(size_t from, size_t old_first, size_t edit_end, std::vector<Token>& fresh);
+
+    /**
+     * @return index one past the last token of the item starting at a token, by counting braces
+     */
+    uint32_t item_end(uint32_t first) const;
+
+    /**
+     * @return index of the LBRACE opening the body of a function item, or the end of the item if it cannot be skimmed
+     */
+    uint32_t body_start(const Item& item) const;
+
+    /**
+     * Parse a run of items by replaying their tokens followed by SCANEOF, the trees they had are deleted
+     * @param skim_bodies: replay the function items of the run without their bodies
+     * @return false on a syntax error, the items are then left as they were
+     */
+    bool parse_items(size_t first_item, size_t end_item, bool skim_bodies);
+
+    void rebuild_root();
+
+private:
+    bool skim;
+    std::string text;           // the current version, followed by the two NULs flex needs
+    size_t length = 0;          // of the current version, without the NULs
+    bool started = false;
+    std::vector<Token> token_buffer;    // SCANEOF last, offsets from the end of the text after the gap
+    size_t gap_start = 0;
+    size_t gap_end = 0;
+    std::vector<uint32_t> reached_end_tokens;   // indices of the tokens with reached_end, ascending
+    std::vector<Item> items;
+    Node* root = nullptr;       // program node over the declarations of the items, they are not its to delete
+    Stats last_stats;
+};
+
+#endif  // CSC4180_INCREMENTAL_PARSER_HPP
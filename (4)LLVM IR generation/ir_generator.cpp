@@ -0,0 +1,1365 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 22nd, 2026
+ *
+ * This file implements the LLVM IR Generator class defined in ir_generator.hpp
+ */
+
+#include "ir_generator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <thread>
+
+/**
+ * @return the LLVM element type of an array type, empty if not an array
+ */
+static std::string element_type(DataType datatype) {
+    switch (datatype) {
+        case DataType::INT_ARRAY:       return "i32";
+        case DataType::BOOL_ARRAY:      return "i1";
+        case DataType::STRING_ARRAY:    return "i8*";
+        default:                        return "";
+    }
+}
+
+/**
+ * @return the LLVM type of an array object, { i32 length, [count x element] }
+ */
+static std::string array_struct_type(const std::string &element, const std::string &count = "0") {
+    return "{ i32, [" + count + " x " + element + "] }";
+}
+
+/**
+ * @return the LLVM type of values of an Oat data type
+ */
+static std::string llvm_type(DataType datatype) {
+    switch (datatype) {
+        case DataType::INT:             return "i32";
+        case DataType::BOOL:            return "i1";
+        case DataType::STRING:          return "i8*";
+        case DataType::INT_ARRAY:
+        case DataType::BOOL_ARRAY:
+        case DataType::STRING_ARRAY:    return array_struct_type(element_type(datatype)) + "*";
+        case DataType::VOID:            return "void";
+        default:
+            std::cerr << "Error: unsupported data type in IR generation" << std::endl;
+            return "i32";
+    }
+}
+
+/**
+ * @return whether evaluating the expression has no side effect and cannot trap
+ * Calls, array accesses (bounds checks) and allocations are not pure.
+ */
+static bool is_pure(Node* node) {
+    std::vector<Node*> stack = {node};
+    while (!stack.empty()) {
+        Node* current = stack.back();
+        stack.pop_back();
+        if (current == nullptr) continue;
+        switch (current->symbol_class) {
+            case SymbolClass::func_call:
+            case SymbolClass::array_index:
+            case SymbolClass::new_init_size:
+            case SymbolClass::new_init_value:
+                return false;
+            default:
+                stack.insert(stack.end(), current->children.begin(), current->children.end());
+                break;
+        }
+    }
+    return true;
+}
+
+static bool is_comparison(SymbolClass symbol_class) {
+    switch (symbol_class) {
+        case SymbolClass::LESS:
+        case SymbolClass::LESSEQ:
+        case SymbolClass::GREAT:
+        case SymbolClass::GREATEQ:
+        case SymbolClass::EQ:
+        case SymbolClass::NEQ:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @return whether gen_expression lowers the expression to a single instruction by gen_binary
+ */
+static bool lowers_to_binary(Node* node) {
+    switch (node->symbol_class) {
+        case SymbolClass::MINUS:
+            return node->children.size() == 2;
+        case SymbolClass::STAR:
+        case SymbolClass::PLUS:
+        case SymbolClass::LSHIFT:
+        case SymbolClass::RLSHIFT:
+        case SymbolClass::RASHIFT:
+        case SymbolClass::BAND:
+        case SymbolClass::BOR:
+            return true;
+        case SymbolClass::LAND:
+        case SymbolClass::LOR:
+            return is_pure(node->children[1]);
+        default:
+            return false;
+    }
+}
+
+/**
+ * @return whether evaluating the expression may allocate, and so run the collector
+ */
+static bool may_allocate(Node* node) {
+    std::vector<Node*> stack = {node};
+    while (!stack.empty()) {
+        Node* current = stack.back();
+        stack.pop_back();
+        if (current == nullptr) continue;
+        switch (current->symbol_class) {
+            case SymbolClass::func_call:
+            case SymbolClass::new_init_size:
+            case SymbolClass::new_init_value:
+                return true;
+            default:
+                stack.insert(stack.end(), current->children.begin(), current->children.end());
+                break;
+        }
+    }
+    return false;
+}
+
+/**
+ * @return whether the subtree handles strings or arrays, a function without any needs no shadow stack frame
+ */
+static bool uses_heap(Node* node) {
+    std::vector<Node*> stack = {node};
+    while (!stack.empty()) {
+        Node* current = stack.back();
+        stack.pop_back();
+        if (current == nullptr) continue;
+        switch (current->datatype) {
+            case DataType::STRING:
+            case DataType::INT_ARRAY:
+            case DataType::BOOL_ARRAY:
+            case DataType::STRING_ARRAY:
+                return true;
+            default:
+                stack.insert(stack.end(), current->children.begin(), current->children.end());
+                break;
+        }
+    }
+    return false;
+}
+
+/**
+ * @return whether values of an LLVM type are heap pointers (strings and arrays)
+ */
+static bool is_heap_type(const std::string &type) {
+    return type.back() == '*';
+}
+
+/**
+ * @return the zero value of an LLVM type, used for default returns
+ */
+static std::string zero_value(const std::string &type) {
+    if (type == "i1") return "false";
+    if (type.back() == '*') return "null";
+    return "0";
+}
+
+void IR_Generator::export_ast_to_llvm_ir(Node* node) {
+    if (node == nullptr) {
+        std::cerr << "Error: the ast is empty!" << std::endl;
+        return;
+    }
+    declare_runtime_functions();
+    // signatures first, a function can be called before its definition
+    for (auto &child : node->children) {
+        if (child->symbol_class != SymbolClass::function_decl) continue;
+        Signature signature;
+        signature.return_type = llvm_type(child->children[0]->datatype);
+        for (auto &arg : child->children[2]->children) {
+            signature.param_types.push_back(llvm_type(arg->children[0]->datatype));
+        }
+        signature.symbol = child->children[1]->lexeme;
+        functions[child->children[1]->lexeme] = signature;
+    }
+    collect_string_literals(node);
+    std::vector<Node*> function_nodes;
+    for (auto &child : node->children) {
+        if (child->symbol_class == SymbolClass::function_decl) function_nodes.push_back(child);
+    }
+    std::vector<std::unique_ptr<OutputBuffer>> function_outputs;
+    if (jobs > 1 && function_nodes.size() > 1) function_outputs = gen_functions(function_nodes);
+    size_t next_function = 0;
+    for (auto &child : node->children) {
+        if (child->symbol_class == SymbolClass::global_decl) {
+            gen_global_decl(child);
+        } else if (function_outputs.empty()) {
+            gen_function_decl(child, out);
+        } else {
+            out << function_outputs[next_function]->str();
+            function_outputs[next_function++].reset();
+        }
+    }
+    if (gc) {
+        // the collector updates these locations in place
+        out << "@oat_gc_global_count = global i32 " << global_roots.size() << "\n";
+        out << "@oat_gc_globals = global [" << global_roots.size() << " x i8**] ";
+        if (global_roots.empty()) {
+            out << "zeroinitializer\n\n";
+        } else {
+            out << "[";
+            for (size_t i = 0; i < global_roots.size(); ++i) {
+                out << (i > 0 ? ", " : "") << "i8** " << global_roots[i];
+            }
+            out << "]\n\n";
+        }
+    }
+    out << constants;
+    if (total_checks_emitted > 0) {
+        // the failure branch of bounds checks is cold
+        out << "\n!0 = !{!\"branch_weights\", i32 1048575, i32 1}\n";
+    }
+    out << "\n; bounds checks: " << total_checks_emitted << " emitted, " << total_checks_removed << " removed\n";
+    out.close();
+}
+
+void IR_Generator::collect_string_literals(Node* node) {
+    // pre-order with an explicit stack, children pushed last to first
+    std::vector<Node*> stack = {node};
+    while (!stack.empty()) {
+        Node* current = stack.back();
+        stack.pop_back();
+        if (current == nullptr) continue;
+        if (current->symbol_class == SymbolClass::STRINGLITERAL) string_constant(current->lexeme);
+        stack.insert(stack.end(), current->children.rbegin(), current->children.rend());
+    }
+}
+
+std::vector<std::unique_ptr<OutputBuffer>> IR_Generator::gen_functions(const std::vector<Node*> &function_nodes) {
+    std::vector<std::unique_ptr<OutputBuffer>> outputs(function_nodes.size());
+    unsigned num_threads = std::min<size_t>(jobs, function_nodes.size());
+    // the calling thread works with this generator, every other thread with a copy
+    std::vector<std::unique_ptr<IR_Generator>> workers;
+    for (unsigned i = 1; i < num_threads; ++i)
+        workers.emplace_back(new IR_Generator(*this));
+    std::atomic<size_t> next_function(0);
+    auto work = [&](IR_Generator* generator) {
+        for (size_t i = next_function++; i < function_nodes.size(); i = next_function++) {
+            outputs[i].reset(new OutputBuffer());
+            generator->gen_function_decl(function_nodes[i], *outputs[i]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (auto &worker : workers)
+        threads.emplace_back(work, worker.get());
+    work(this);
+    for (auto &thread : threads)
+        thread.join();
+    for (auto &worker : workers) {
+        total_checks_emitted += worker->total_checks_emitted;
+        total_checks_removed += worker->total_checks_removed;
+    }
+    return outputs;
+}
+
+/*
+ * The builtins of runtime.c, plus its allocator used by new, and the shadow stack top with gc
+ * The builtins reading string lengths map to the oat_* versions using the cached length,
+ * and length_of_string is generated inline.
+ */
+void IR_Generator::declare_runtime_functions() {
+    static const struct {
+        const char* name;
+        const char* symbol;
+        const char* return_type;
+        std::vector<std::string> param_types;
+    } runtime_functions[] = {
+        {"array_of_string", "oat_array_of_string", "i32*", {"i8*"}},
+        {"string_of_array", "string_of_array", "i8*", {"i32*"}},
+        {"length_of_string", "oat_string_length", "i32", {"i8*"}},
+        {"string_of_int", "string_of_int", "i8*", {"i32"}},
+        {"string_cat", "oat_string_cat", "i8*", {"i8*", "i8*"}},
+        {"print_string", "oat_print_string", "void", {"i8*"}},
+        {"print_int", "print_int", "void", {"i32"}},
+        {"print_bool", "print_bool", "void", {"i32"}},
+        {"oat_alloc", "oat_alloc", "i8*", {"i32", "i32"}},
+    };
+    out << "; Declare runtime functions\n";
+    for (auto &function : runtime_functions) {
+        out << "declare " << function.return_type << " @" << function.symbol << "(";
+        for (size_t i = 0; i < function.param_types.size(); ++i) {
+            out << (i > 0 ? ", " : "") << function.param_types[i];
+        }
+        out << ")\n";
+        functions[function.name] = Signature{function.return_type, function.param_types, function.symbol};
+    }
+    out << "; Failed array bounds checks\n";
+    out << "declare void @llvm.trap()\n";
+    if (gc) out << "@oat_gc_top = external global i8*\n";
+    out << "\n";
+}
+
+/*
+ * global x = 5;            @x-1 = global i32 5
+ * global s = "abc";        @s-1 = global i8* getelementptr inbounds ({ i32, i32, [4 x i8] }, ... @.str.1, i32 0, i32 2, i32 0)
+ * global a = new int[]{1}; @a-1.init = private global { i32, [1 x i32] } { i32 1, [1 x i32] [i32 1] }
+ *                          @a-1 = global { i32, [0 x i32] }* bitcast (... @a-1.init to { i32, [0 x i32] }*)
+ */
+void IR_Generator::gen_global_decl(Node* node) {
+    Node* id_node = node->children[0];
+    std::string name = id_node->unique_name();
+    std::string type = llvm_type(id_node->datatype);
+    std::string value = gen_global_constant(node->children[1], name);
+    out << "@" << name << " = global " << type << " " << value << "\n\n";
+    if (gc && is_heap_type(type)) {
+        global_roots.push_back("bitcast (" + type + "* @" + name + " to i8**)");
+    }
+}
+
+std::string IR_Generator::gen_global_constant(Node* node, const std::string &name) {
+    switch (node->symbol_class) {
+        case SymbolClass::INTLITERAL:
+            return node->lexeme;
+        case SymbolClass::TRUE:
+            return "true";
+        case SymbolClass::FALSE:
+            return "false";
+        case SymbolClass::NUL:
+            return "null";
+        case SymbolClass::STRINGLITERAL:
+            return string_constant(node->lexeme);
+        case SymbolClass::NEW: {
+            std::string element = element_type(node->datatype);
+            Node* exps = node->children[1];
+            size_t count = exps == nullptr ? 0 : exps->children.size();
+            std::string init_type = array_struct_type(element, std::to_string(count));
+            std::string elements;
+            for (size_t i = 0; i < count; ++i) {
+                Node* exp = exps->children[i];
+                std::string value = gen_global_constant(exp, name + "." + std::to_string(i));
+                elements += (i > 0 ? ", " : "") + element + " " + value;
+            }
+            out << "@" << name << ".init = private global " << init_type << " { i32 " << count
+                << ", [" << count << " x " << element << "] [" << elements << "] }\n";
+            // the elements of a static string[] may be assigned heap strings later
+            for (size_t i = 0; gc && element == "i8*" && i < count; ++i) {
+                global_roots.push_back("getelementptr inbounds (" + init_type + ", " + init_type + "* @" + name
+                                       + ".init, i32 0, i32 1, i32 " + std::to_string(i) + ")");
+            }
+            return "bitcast (" + init_type + "* @" + name + ".init to " + llvm_type(node->datatype) + ")";
+        }
+        default:
+            std::cerr << "Error: unsupported global initializer" << std::endl;
+            return "zeroinitializer";
+    }
+}
+
+/*
+ * define i32 @f(i32 %a.arg) {
+ * entry:
+ *   %a-2 = alloca i32                  ; allocas of the arguments and all local variables
+ *   store i32 %a.arg, i32* %a-2
+ *   ...                                ; body
+ * }
+ * With gc, a function handling strings or arrays also pushes its frame after the allocas:
+ *   %_gc_frame = alloca { i8*, i32, [N x i8*] }
+ *   %s-2.slot = getelementptr ..., i32 0, i32 2, i32 k      ; one null-initialized root per heap pointer
+ *   %s-2 = bitcast i8** %s-2.slot to i8**                   ; local, parameter or spill slot
+ *   %_gc_prev = load i8*, i8** @oat_gc_top                 ; stored into field 0, N into field 1
+ *   store i8* <frame>, i8** @oat_gc_top                    ; and %_gc_prev back before every ret
+ */
+void IR_Generator::gen_function_decl(Node* node, OutputBuffer &function_out) {
+    std::string name = node->children[1]->lexeme;
+    const Signature &signature = functions[name];
+    body.reset(new OutputBuffer());
+    allocas.clear();
+    param_stores.clear();
+    locals.clear();
+    root_slots.clear();
+    free_spill_slots.clear();
+    spill_counter = 0;
+    frame = gc && uses_heap(node);
+    loop_ranges.clear();
+    checks_emitted = 0;
+    checks_removed = 0;
+    analyze_locals(node);
+    return_type = signature.return_type;
+    tmp_counter = 0;
+    label_counter = 0;
+    current_block = "entry";
+    terminated = false;
+
+    std::string params;
+    Node* args = node->children[2];
+    for (size_t i = 0; i < args->children.size(); ++i) {
+        Node* id_node = args->children[i]->children[1];
+        std::string type = signature.param_types[i];
+        std::string unique_name = id_node->unique_name();
+        params += (i > 0 ? ", " : "") + type + " %" + id_node->lexeme + ".arg";
+        declare_local(unique_name, type);
+        param_stores += "\tstore " + type + " %" + id_node->lexeme + ".arg, " + type + "* %" + unique_name + "\n";
+    }
+
+    gen_statement(node->children[3]);
+    if (!terminated) {
+        // falling off the end returns the zero value
+        emit_return(return_type == "void" ? "" : zero_value(return_type));
+    }
+    if (checks_emitted > 0) {
+        *body << "bounds_fail:\n";
+        *body << "\tcall void @llvm.trap()\n";
+        *body << "\tunreachable\n";
+    }
+    total_checks_emitted += checks_emitted;
+    total_checks_removed += checks_removed;
+
+    if (checks_emitted + checks_removed > 0) {
+        function_out << "; bounds checks: " << checks_emitted << " emitted, " << checks_removed << " removed\n";
+    }
+    function_out << "define " << return_type << " @" << name << "(" << params << ") {\n";
+    function_out << "entry:\n";
+    function_out << allocas;
+    if (frame) {
+        std::string frame_type = "{ i8*, i32, [" + std::to_string(root_slots.size()) + " x i8*] }";
+        function_out << "\t%_gc_frame = alloca " << frame_type << "\n";
+        for (size_t k = 0; k < root_slots.size(); ++k) {
+            const std::string &slot = root_slots[k].first;
+            function_out << "\t%" << slot << ".slot = getelementptr " << frame_type << ", " << frame_type
+                << "* %_gc_frame, i32 0, i32 2, i32 " << k << "\n";
+            function_out << "\tstore i8* null, i8** %" << slot << ".slot\n";
+            function_out << "\t%" << slot << " = bitcast i8** %" << slot << ".slot to " << root_slots[k].second << "*\n";
+        }
+        function_out << "\t%_gc_prev = load i8*, i8** @oat_gc_top\n";
+        function_out << "\t%_gc_prev.field = getelementptr " << frame_type << ", " << frame_type << "* %_gc_frame, i32 0, i32 0\n";
+        function_out << "\tstore i8* %_gc_prev, i8** %_gc_prev.field\n";
+        function_out << "\t%_gc_count.field = getelementptr " << frame_type << ", " << frame_type
+            << "* %_gc_frame, i32 0, i32 1\n";
+        function_out << "\tstore i32 " << root_slots.size() << ", i32* %_gc_count.field\n";
+        function_out << "\t%_gc_frame.raw = bitcast " << frame_type << "* %_gc_frame to i8*\n";
+        function_out << "\tstore i8* %_gc_frame.raw, i8** @oat_gc_top\n";
+    }
+    function_out << param_stores;
+    function_out << body->str();
+    function_out << "}\n\n";
+    body.reset();
+}
+
+/*
+ * A local is constant when it is never assigned (nor a parameter) and all its var_decls agree,
+ * so its value, or the length of the array it holds, is known wherever it is in scope.
+ */
+void IR_Generator::analyze_locals(Node* node) {
+    std::map<std::string, std::vector<Node*>> inits;
+    std::set<std::string> assigned;
+    for (auto &arg : node->children[2]->children) {
+        assigned.insert(arg->children[1]->unique_name());
+    }
+    std::vector<Node*> stack = {node->children[3]};
+    while (!stack.empty()) {
+        Node* current = stack.back();
+        stack.pop_back();
+        if (current == nullptr) continue;
+        if (current->symbol_class == SymbolClass::var_decl) {
+            inits[current->children[0]->unique_name()].push_back(current->children[1]);
+        } else if (current->symbol_class == SymbolClass::ASSIGN
+                   && current->children[0]->symbol_class == SymbolClass::ID) {
+            assigned.insert(current->children[0]->unique_name());
+        }
+        for (auto &child : current->children) {
+            stack.push_back(child);
+        }
+    }
+
+    int_constants.clear();
+    array_lengths.clear();
+    for (auto &entry : inits) {
+        if (assigned.count(entry.first) > 0 || entry.second[0]->datatype != DataType::INT) continue;
+        int64_t value;
+        bool constant = true;
+        for (Node* init : entry.second) {
+            int64_t other;
+            if (init->symbol_class != SymbolClass::INTLITERAL || !constant_value(init, other)
+                || (init != entry.second[0] && other != value)) {
+                constant = false;
+                break;
+            }
+            value = other;
+        }
+        if (constant) int_constants[entry.first] = value;
+    }
+    for (auto &entry : inits) {
+        if (assigned.count(entry.first) > 0) continue;
+        int64_t min_length = INT32_MAX;
+        for (Node* init : entry.second) {
+            int64_t length = -1;
+            if (init->symbol_class == SymbolClass::new_init_size) {
+                if (!constant_value(init->children[1], length)) length = -1;
+            } else if (init->symbol_class == SymbolClass::new_init_value) {
+                length = init->children[1] == nullptr ? 0 : init->children[1]->children.size();
+            }
+            if (length < 0) {
+                min_length = -1;
+                break;
+            }
+            min_length = std::min(min_length, length);
+        }
+        if (min_length >= 0) array_lengths[entry.first] = min_length;
+    }
+}
+
+bool IR_Generator::constant_value(Node* node, int64_t &value) {
+    switch (node->symbol_class) {
+        case SymbolClass::INTLITERAL: {
+            errno = 0;
+            char* end;
+            long long parsed = std::strtoll(node->lexeme.c_str(), &end, 10);
+            if (errno != 0 || *end != '\0' || parsed > INT32_MAX) return false;
+            value = parsed;
+            return true;
+        }
+        case SymbolClass::MINUS:
+            if (node->children.size() != 1 || node->children[0]->symbol_class != SymbolClass::INTLITERAL) return false;
+            if (!constant_value(node->children[0], value)) return false;
+            value = -value;
+            return true;
+        case SymbolClass::ID: {
+            if (node->scope_id == 1) return false;
+            auto it = int_constants.find(node->unique_name());
+            if (it == int_constants.end()) return false;
+            value = it->second;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+/**
+ * @return whether an assignment to the variable appears in the subtree
+ */
+static bool assigns(Node* node, const std::string &unique_name) {
+    std::vector<Node*> stack = {node};
+    while (!stack.empty()) {
+        Node* current = stack.back();
+        stack.pop_back();
+        if (current == nullptr) continue;
+        if (current->symbol_class == SymbolClass::ASSIGN && current->children[0]->symbol_class == SymbolClass::ID
+            && current->children[0]->unique_name() == unique_name) {
+            return true;
+        }
+        stack.insert(stack.end(), current->children.begin(), current->children.end());
+    }
+    return false;
+}
+
+/*
+ * The body only runs when i < c1 (or i <= c1), and i only grows from c0 by k without overflowing,
+ * so i stays within [c0, c1 - 1] in the body and the update.
+ */
+bool IR_Generator::loop_range(Node* node, IndexRange &range) {
+    Node* decls = node->children[0];
+    Node* cond = node->children[1];
+    Node* update = node->children[2];
+    if (decls == nullptr || cond == nullptr || update == nullptr) return false;
+    if ((cond->symbol_class != SymbolClass::LESS && cond->symbol_class != SymbolClass::LESSEQ)
+        || cond->children[0]->symbol_class != SymbolClass::ID) {
+        return false;
+    }
+    std::string name = cond->children[0]->unique_name();
+    int64_t low = -1;
+    for (auto &decl : decls->children) {
+        if (decl->children[0]->unique_name() == name && !constant_value(decl->children[1], low)) return false;
+    }
+    int64_t bound;
+    if (low < 0 || !constant_value(cond->children[1], bound)) return false;
+
+    // i = i + k or i = k + i
+    if (update->symbol_class != SymbolClass::ASSIGN || update->children[0]->symbol_class != SymbolClass::ID
+        || update->children[0]->unique_name() != name || update->children[1]->symbol_class != SymbolClass::PLUS) {
+        return false;
+    }
+    Node* sum = update->children[1];
+    int64_t step;
+    Node* operand = sum->children[0];
+    if (!constant_value(sum->children[1], step)) {
+        operand = sum->children[1];
+        if (!constant_value(sum->children[0], step)) return false;
+    }
+    if (operand->symbol_class != SymbolClass::ID || operand->unique_name() != name || step <= 0) return false;
+
+    int64_t high = cond->symbol_class == SymbolClass::LESS ? bound - 1 : bound;
+    if (high + step > INT32_MAX || assigns(node->children[3], name)) return false;
+    range = IndexRange{name, low, high};
+    return true;
+}
+
+/*
+ * Provable indexes of a local array of constant length n: a constant in [0, n), i or i +/- c for the
+ * variable i of an enclosing counting loop, when its whole range shifted by c is in [0, n)
+ */
+bool IR_Generator::index_in_bounds(Node* array_node, Node* index_node) {
+    if (array_node->symbol_class != SymbolClass::ID || array_node->scope_id == 1) return false;
+    auto it = array_lengths.find(array_node->unique_name());
+    if (it == array_lengths.end()) return false;
+    int64_t length = it->second;
+
+    int64_t value;
+    if (constant_value(index_node, value)) return value >= 0 && value < length;
+    Node* variable = index_node;
+    int64_t offset = 0;
+    if ((index_node->symbol_class == SymbolClass::PLUS || index_node->symbol_class == SymbolClass::MINUS)
+        && index_node->children.size() == 2) {
+        bool is_plus = index_node->symbol_class == SymbolClass::PLUS;
+        if (constant_value(index_node->children[1], offset)) {
+            variable = index_node->children[0];
+            if (!is_plus) offset = -offset;
+        } else if (is_plus && constant_value(index_node->children[0], offset)) {
+            variable = index_node->children[1];
+        } else {
+            return false;
+        }
+    }
+    if (variable->symbol_class != SymbolClass::ID) return false;
+    for (auto &range : loop_ranges) {
+        if (range.name == variable->unique_name()) {
+            return range.low + offset >= 0 && range.high + offset < length;
+        }
+    }
+    return false;
+}
+
+bool IR_Generator::declare_local(const std::string &unique_name, const std::string &type) {
+    auto it = locals.find(unique_name);
+    if (it != locals.end()) return it->second == type;
+    locals.emplace(unique_name, type);
+    if (frame && is_heap_type(type)) {
+        root_slots.emplace_back(unique_name, type);
+    } else {
+        allocas += "\t%" + unique_name + " = alloca " + type + "\n";
+    }
+    return true;
+}
+
+void IR_Generator::emit_return(const std::string &value) {
+    if (frame) emit() << "store i8* %_gc_prev, i8** @oat_gc_top\n";
+    if (value.empty()) {
+        emit() << "ret void\n";
+    } else {
+        emit() << "ret " << return_type << " " << value << "\n";
+    }
+    terminated = true;
+}
+
+void IR_Generator::gen_statement(Node* node) {
+    if (node == nullptr) return;
+    switch (node->symbol_class) {
+        case SymbolClass::var_decl:
+            gen_var_decl(node);
+            break;
+        case SymbolClass::ASSIGN:
+            gen_assign(node);
+            break;
+        case SymbolClass::RETURN:
+            gen_return(node);
+            break;
+        case SymbolClass::func_call:
+            gen_call(node);
+            break;
+        case SymbolClass::IF:
+            gen_if(node);
+            break;
+        case SymbolClass::FOR:
+            gen_for(node);
+            break;
+        case SymbolClass::WHILE:
+            gen_while(node);
+            break;
+        default:
+            // stmts, var_decls
+            for (auto &child : node->children) {
+                gen_statement(child);
+            }
+            break;
+    }
+}
+
+/*
+ * %x-2 = alloca i32            (in the entry block, once per unique name)
+ * store i32 <value>, i32* %x-2
+ */
+void IR_Generator::gen_var_decl(Node* node) {
+    Node* id_node = node->children[0];
+    std::string type = llvm_type(id_node->datatype);
+    std::string unique_name = id_node->unique_name();
+    if (!declare_local(unique_name, type)) {
+        std::cerr << "Error: " << id_node->lexeme << " is redeclared with another type" << std::endl;
+        return;
+    }
+    std::string value = gen_expression(node->children[1]);
+    emit() << "store " << type << " " << value << ", " << type << "* %" << unique_name << "\n";
+}
+
+/*
+ * a[i] = v checks the bounds before evaluating v, the array is read back from its root afterwards
+ * when v may run the collector
+ */
+void IR_Generator::gen_assign(Node* node) {
+    Node* lhs = node->children[0];
+    Node* rhs = node->children[1];
+    std::string type = llvm_type(lhs->datatype);
+    if (lhs->symbol_class != SymbolClass::array_index) {
+        std::string value = gen_expression(rhs);
+        emit() << "store " << type << " " << value << ", " << type << "* " << variable_pointer(lhs) << "\n";
+        return;
+    }
+    DataType array_datatype = lhs->children[0]->datatype;
+    std::string array_type = llvm_type(array_datatype);
+    std::string array = gen_expression(lhs->children[0]);
+    std::string slot = spill(array, array_type, may_allocate(lhs->children[1]) || may_allocate(rhs));
+    std::string index = gen_expression(lhs->children[1]);
+    if (may_allocate(lhs->children[1])) array = reload(slot, array_type, array);
+    check_index(lhs->children[0], lhs->children[1], array, index);
+    std::string value = gen_expression(rhs);
+    if (may_allocate(rhs)) array = reload(slot, array_type, array);
+    release(slot, array_type);
+    std::string pointer = element_pointer(array_datatype, array, index);
+    emit() << "store " << type << " " << value << ", " << type << "* " << pointer << "\n";
+}
+
+void IR_Generator::gen_return(Node* node) {
+    if (node->children.empty() || return_type == "void") {
+        emit_return("");
+    } else {
+        emit_return(gen_expression(node->children[0]));
+    }
+}
+
+/*
+ *   br i1 <cond>, label %if_then_N, label %if_else_N
+ * if_then_N:
+ *   ...
+ *   br label %if_end_N
+ * if_else_N:                   (omitted without else)
+ *   ...
+ *   br label %if_end_N
+ * if_end_N:
+ */
+void IR_Generator::gen_if(Node* node) {
+    Node* else_body = node->children[2]->children.empty() ? nullptr : node->children[2]->children[0];
+    std::string then_label = new_label("if_then");
+    std::string else_label = else_body != nullptr ? new_label("if_else") : "";
+    std::string end_label = new_label("if_end");
+
+    gen_branch(node->children[0], then_label, else_body != nullptr ? else_label : end_label);
+    emit_label(then_label);
+    gen_statement(node->children[1]);
+    emit_branch(end_label);
+    if (else_body != nullptr) {
+        emit_label(else_label);
+        gen_statement(else_body);
+        emit_branch(end_label);
+    }
+    emit_label(end_label);
+}
+
+/*
+ *   <var_decls>
+ *   br label %for_cond_N
+ * for_cond_N:
+ *   br i1 <cond>, label %for_body_N, label %for_end_N
+ * for_body_N:
+ *   <stmts>
+ *   <update>
+ *   br label %for_cond_N
+ * for_end_N:
+ */
+void IR_Generator::gen_for(Node* node) {
+    std::string cond_label = new_label("for_cond");
+    std::string body_label = new_label("for_body");
+    std::string end_label = new_label("for_end");
+
+    gen_statement(node->children[0]);
+    emit_branch(cond_label);
+    emit_label(cond_label);
+    if (node->children[1] != nullptr) {
+        gen_branch(node->children[1], body_label, end_label);
+    } else {
+        emit_branch(body_label);
+    }
+    emit_label(body_label);
+    IndexRange range;
+    bool counting = loop_range(node, range);
+    if (counting) loop_ranges.push_back(range);
+    gen_statement(node->children[3]);
+    gen_statement(node->children[2]);
+    if (counting) loop_ranges.pop_back();
+    emit_branch(cond_label);
+    emit_label(end_label);
+}
+
+/*
+ *   br label %while_cond_N
+ * while_cond_N:
+ *   br i1 <cond>, label %while_body_N, label %while_end_N
+ * while_body_N:
+ *   ...
+ *   br label %while_cond_N
+ * while_end_N:
+ */
+void IR_Generator::gen_while(Node* node) {
+    std::string cond_label = new_label("while_cond");
+    std::string body_label = new_label("while_body");
+    std::string end_label = new_label("while_end");
+
+    emit_branch(cond_label);
+    emit_label(cond_label);
+    gen_branch(node->children[0], body_label, end_label);
+    emit_label(body_label);
+    gen_statement(node->children[1]);
+    emit_branch(cond_label);
+    emit_label(end_label);
+}
+
+/*
+ * a & f():  br a, %and_rhs_N, <false>          a & b (pure):  %t = and i1 a, b
+ *         and_rhs_N:                                          br i1 %t, <true>, <false>
+ *           br f(), <true>, <false>
+ * Pure operands are combined without branches, so a loop condition like i < n & j < m costs one branch.
+ */
+void IR_Generator::gen_branch(Node* node, const std::string &true_label, const std::string &false_label) {
+    switch (node->symbol_class) {
+        case SymbolClass::LAND:
+        case SymbolClass::LOR: {
+            if (is_pure(node->children[1])) break;
+            bool is_and = node->symbol_class == SymbolClass::LAND;
+            std::string rhs_label = new_label(is_and ? "and_rhs" : "or_rhs");
+            if (is_and) {
+                gen_branch(node->children[0], rhs_label, false_label);
+            } else {
+                gen_branch(node->children[0], true_label, rhs_label);
+            }
+            emit_label(rhs_label);
+            gen_branch(node->children[1], true_label, false_label);
+            return;
+        }
+        case SymbolClass::NOT:
+            gen_branch(node->children[0], false_label, true_label);
+            return;
+        default:
+            break;
+    }
+    std::string cond = gen_expression(node);
+    if (node->datatype != DataType::BOOL) {
+        std::string tmp = new_tmp();
+        emit() << tmp << " = icmp ne " << llvm_type(node->datatype) << " " << cond << ", "
+               << zero_value(llvm_type(node->datatype)) << "\n";
+        cond = tmp;
+    }
+    emit_cond_branch(cond, true_label, false_label);
+}
+
+std::string IR_Generator::gen_expression(Node* node) {
+    switch (node->symbol_class) {
+        case SymbolClass::INTLITERAL:
+            return node->lexeme;
+        case SymbolClass::TRUE:
+            return "true";
+        case SymbolClass::FALSE:
+            return "false";
+        case SymbolClass::NUL:
+            return "null";
+        case SymbolClass::STRINGLITERAL:
+            return string_constant(node->lexeme);
+        case SymbolClass::ID: {
+            std::string type = llvm_type(node->datatype);
+            std::string tmp = new_tmp();
+            emit() << tmp << " = load " << type << ", " << type << "* " << variable_pointer(node) << "\n";
+            return tmp;
+        }
+        case SymbolClass::func_call:
+            return gen_call(node);
+        case SymbolClass::array_index: {
+            std::string type = llvm_type(node->datatype);
+            std::string pointer = gen_element_pointer(node);
+            std::string tmp = new_tmp();
+            emit() << tmp << " = load " << type << ", " << type << "* " << pointer << "\n";
+            return tmp;
+        }
+        case SymbolClass::new_init_size: {
+            std::string length = gen_expression(node->children[1]);
+            return gen_new_array(node->datatype, length);
+        }
+        case SymbolClass::new_init_value: {
+            Node* exps = node->children[1];
+            size_t count = exps == nullptr ? 0 : exps->children.size();
+            std::string array_type = llvm_type(node->datatype);
+            std::string element = element_type(node->datatype);
+            std::string array = gen_new_array(node->datatype, std::to_string(count));
+            bool allocating = false;
+            for (size_t i = 0; i < count; ++i) {
+                allocating = allocating || may_allocate(exps->children[i]);
+            }
+            std::string slot = spill(array, array_type, allocating);
+            for (size_t i = 0; i < count; ++i) {
+                std::string value = gen_expression(exps->children[i]);
+                if (may_allocate(exps->children[i])) array = reload(slot, array_type, array);
+                std::string pointer = element_pointer(node->datatype, array, std::to_string(i));
+                emit() << "store " << element << " " << value << ", " << element << "* " << pointer << "\n";
+            }
+            release(slot, array_type);
+            return array;
+        }
+        case SymbolClass::MINUS:
+            if (node->children.size() == 1) return gen_unary(node);
+            return gen_binary(node);
+        case SymbolClass::NOT:
+        case SymbolClass::TILDE:
+            return gen_unary(node);
+        case SymbolClass::STAR:
+        case SymbolClass::PLUS:
+        case SymbolClass::LSHIFT:
+        case SymbolClass::RLSHIFT:
+        case SymbolClass::RASHIFT:
+        case SymbolClass::BAND:
+        case SymbolClass::BOR:
+            return gen_binary(node);
+        case SymbolClass::LESS:
+        case SymbolClass::LESSEQ:
+        case SymbolClass::GREAT:
+        case SymbolClass::GREATEQ:
+        case SymbolClass::EQ:
+        case SymbolClass::NEQ:
+            return gen_comparison(node, false);
+        case SymbolClass::LAND:
+        case SymbolClass::LOR:
+            // both operands are evaluated anyway when the right one is pure, so plain and/or avoids branches
+            if (!is_pure(node->children[1])) return gen_short_circuit(node);
+            return gen_binary(node);
+        default:
+            std::cerr << "Error: unsupported expression " << symbol_class_to_str(node->symbol_class) << std::endl;
+            return "undef";
+    }
+}
+
+/*
+ * %_tmp_N = <op> <type> <lhs>, <rhs>
+ * Arithmetic and bitwise operators work on i32, & and | are the logical and/or of i1.
+ * Nested binary operators are walked with an explicit stack, so a long chain like 1 + (1 + (...)) does not
+ * overflow the call stack; other operands go through gen_expression. Their operands are never heap pointers,
+ * so nothing needs a gc root in between.
+ */
+std::string IR_Generator::gen_binary(Node* node) {
+    struct Frame {
+        Node* node;
+        size_t next_operand;        // 0: lhs, 1: rhs, 2: both evaluated
+        std::string lhs;
+    };
+    std::vector<Frame> stack = {{node, 0, ""}};
+    std::string result;             // operand of the last expression evaluated
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        if (frame.next_operand == 1) frame.lhs = result;
+        if (frame.next_operand < 2) {
+            Node* operand = frame.node->children[frame.next_operand++];
+            if (lowers_to_binary(operand)) {
+                stack.push_back({operand, 0, ""});
+            } else {
+                result = gen_expression(operand);
+            }
+            continue;
+        }
+        std::string op;
+        switch (frame.node->symbol_class) {
+            case SymbolClass::STAR:     op = "mul"; break;
+            case SymbolClass::PLUS:     op = "add"; break;
+            case SymbolClass::MINUS:    op = "sub"; break;
+            case SymbolClass::LSHIFT:   op = "shl"; break;
+            case SymbolClass::RLSHIFT:  op = "lshr"; break;
+            case SymbolClass::RASHIFT:  op = "ashr"; break;
+            case SymbolClass::LAND:
+            case SymbolClass::BAND:     op = "and"; break;
+            case SymbolClass::LOR:
+            case SymbolClass::BOR:      op = "or"; break;
+            default: break;
+        }
+        std::string tmp = new_tmp();
+        emit() << tmp << " = " << op << " " << llvm_type(frame.node->children[0]->datatype) << " " << frame.lhs
+               << ", " << result << "\n";
+        result = tmp;
+        stack.pop_back();
+    }
+    return result;
+}
+
+/*
+ * %_tmp_N = icmp <predicate> <type> <lhs>, <rhs>
+ * == and != also compare bools, strings and arrays, the others compare signed integers.
+ */
+std::string IR_Generator::gen_comparison(Node* node, bool negate) {
+    const char* predicate = "";
+    switch (node->symbol_class) {
+        case SymbolClass::LESS:     predicate = negate ? "sge" : "slt"; break;
+        case SymbolClass::LESSEQ:   predicate = negate ? "sgt" : "sle"; break;
+        case SymbolClass::GREAT:    predicate = negate ? "sle" : "sgt"; break;
+        case SymbolClass::GREATEQ:  predicate = negate ? "slt" : "sge"; break;
+        case SymbolClass::EQ:       predicate = negate ? "ne" : "eq"; break;
+        case SymbolClass::NEQ:      predicate = negate ? "eq" : "ne"; break;
+        default: break;
+    }
+    std::string type = llvm_type(node->children[0]->datatype);
+    std::string lhs = gen_expression(node->children[0]);
+    std::string slot = spill(lhs, type, may_allocate(node->children[1]));
+    std::string rhs = gen_expression(node->children[1]);
+    lhs = reload(slot, type, lhs);
+    release(slot, type);
+    std::string tmp = new_tmp();
+    emit() << tmp << " = icmp " << predicate << " " << type << " "
+           << lhs << ", " << rhs << "\n";
+    return tmp;
+}
+
+/*
+ *   <lhs>                                    ; ends in block %L
+ *   br i1 <lhs>, label %and_rhs_N, label %and_end_N      (| swaps the targets)
+ * and_rhs_N:
+ *   <rhs>                                    ; ends in block %R
+ *   br label %and_end_N
+ * and_end_N:
+ *   %_tmp_M = phi i1 [ false, %L ], [ <rhs>, %R ]        (true for |)
+ */
+std::string IR_Generator::gen_short_circuit(Node* node) {
+    bool is_and = node->symbol_class == SymbolClass::LAND;
+    std::string rhs_label = new_label(is_and ? "and_rhs" : "or_rhs");
+    std::string end_label = new_label(is_and ? "and_end" : "or_end");
+
+    std::string lhs = gen_expression(node->children[0]);
+    std::string lhs_block = current_block;
+    if (is_and) {
+        emit_cond_branch(lhs, rhs_label, end_label);
+    } else {
+        emit_cond_branch(lhs, end_label, rhs_label);
+    }
+    emit_label(rhs_label);
+    std::string rhs = gen_expression(node->children[1]);
+    std::string rhs_block = current_block;
+    emit_branch(end_label);
+    emit_label(end_label);
+    std::string tmp = new_tmp();
+    emit() << tmp << " = phi i1 [ " << (is_and ? "false" : "true") << ", %" << lhs_block << " ], [ "
+           << rhs << ", %" << rhs_block << " ]\n";
+    return tmp;
+}
+
+/*
+ * -x: sub i32 0, x         !b: xor i1 b, true          ~x: xor i32 x, -1
+ * !(a < b) is the single comparison a >= b, and !!b is b.
+ */
+std::string IR_Generator::gen_unary(Node* node) {
+    Node* operand = node->children[0];
+    if (node->symbol_class == SymbolClass::NOT) {
+        if (is_comparison(operand->symbol_class)) return gen_comparison(operand, true);
+        if (operand->symbol_class == SymbolClass::NOT) return gen_expression(operand->children[0]);
+    }
+    std::string value = gen_expression(operand);
+    std::string tmp = new_tmp();
+    switch (node->symbol_class) {
+        case SymbolClass::MINUS:
+            emit() << tmp << " = sub i32 0, " << value << "\n";
+            break;
+        case SymbolClass::NOT:
+            emit() << tmp << " = xor i1 " << value << ", true\n";
+            break;
+        default:
+            emit() << tmp << " = xor i32 " << value << ", -1\n";
+            break;
+    }
+    return tmp;
+}
+
+std::string IR_Generator::gen_call(Node* node) {
+    std::string name = node->children[0]->lexeme;
+    auto it = functions.find(name);
+    if (it == functions.end()) {
+        std::cerr << "Error: function not defined: " << name << std::endl;
+        return "undef";
+    }
+    const Signature &signature = it->second;
+    Node* exps = node->children[1];
+    size_t count = exps == nullptr ? 0 : exps->children.size();
+    if (count != signature.param_types.size()) {
+        std::cerr << "Error: wrong number of arguments to " << name << std::endl;
+        return "undef";
+    }
+    // an argument is spilled while a later one may run the collector
+    std::vector<std::string> values(count), slots(count);
+    for (size_t i = 0; i < count; ++i) {
+        Node* exp = exps->children[i];
+        bool later_allocates = false;
+        for (size_t j = i + 1; j < count; ++j) {
+            later_allocates = later_allocates || may_allocate(exps->children[j]);
+        }
+        values[i] = gen_expression(exp);
+        slots[i] = spill(values[i], llvm_type(exp->datatype), later_allocates);
+    }
+    std::string args;
+    for (size_t i = 0; i < count; ++i) {
+        Node* exp = exps->children[i];
+        std::string type = llvm_type(exp->datatype);
+        std::string value = reload(slots[i], type, values[i]);
+        release(slots[i], type);
+        values[i] = convert(value, type, signature.param_types[i]);
+        args += (i > 0 ? ", " : "") + signature.param_types[i] + " " + values[i];
+    }
+    if (signature.symbol == "oat_string_length") return gen_string_length(values[0]);
+    if (signature.return_type == "void") {
+        emit() << "call void @" << signature.symbol << "(" << args << ")\n";
+        return "";
+    }
+    std::string tmp = new_tmp();
+    emit() << tmp << " = call " << signature.return_type << " @" << signature.symbol << "(" << args << ")\n";
+    if (node->datatype == DataType::NONE || node->datatype == DataType::VOID) return tmp;
+    return convert(tmp, signature.return_type, llvm_type(node->datatype));
+}
+
+/*
+ * %chars = bitcast i8* <str> to i32*
+ * %field = getelementptr i32, i32* %chars, i32 -1
+ * %len = load i32, i32* %field
+ */
+std::string IR_Generator::gen_string_length(const std::string &str) {
+    std::string chars = new_tmp();
+    emit() << chars << " = bitcast i8* " << str << " to i32*\n";
+    std::string field = new_tmp();
+    emit() << field << " = getelementptr i32, i32* " << chars << ", i32 -1\n";
+    std::string length = new_tmp();
+    emit() << length << " = load i32, i32* " << field << "\n";
+    return length;
+}
+
+/*
+ * The size of { i32, [n x T] } is the address of element n when the array is at null,
+ * so it follows the target data layout:
+ * %end = getelementptr { i32, [0 x T] }, { i32, [0 x T] }* null, i32 0, i32 1, i32 n
+ * %size = ptrtoint T* %end to i64, truncated to i32
+ * %raw = call i8* @oat_alloc(i32 %size, i32 kind)   ; zero-filled, so elements start as 0 / false / null
+ *                                                   ; kind 1 marks string[], whose elements the collector scans
+ * store i32 n, i32* <length field>
+ */
+std::string IR_Generator::gen_new_array(DataType datatype, const std::string &length) {
+    std::string array_type = llvm_type(datatype);
+    std::string object_type = array_struct_type(element_type(datatype));
+    std::string end = new_tmp();
+    emit() << end << " = getelementptr " << object_type << ", " << array_type << " null, i32 0, i32 1, i32 "
+           << length << "\n";
+    std::string size64 = new_tmp();
+    emit() << size64 << " = ptrtoint " << element_type(datatype) << "* " << end << " to i64\n";
+    std::string size = new_tmp();
+    emit() << size << " = trunc i64 " << size64 << " to i32\n";
+    std::string raw = new_tmp();
+    emit() << raw << " = call i8* @oat_alloc(i32 " << size << ", i32 "
+           << (datatype == DataType::STRING_ARRAY ? 1 : 0) << ")\n";
+    std::string array = new_tmp();
+    emit() << array << " = bitcast i8* " << raw << " to " << array_type << "\n";
+    std::string length_pointer = new_tmp();
+    emit() << length_pointer << " = getelementptr " << object_type << ", " << array_type << " " << array
+           << ", i32 0, i32 0\n";
+    emit() << "store i32 " << length << ", i32* " << length_pointer << "\n";
+    return array;
+}
+
+/*
+ *   %len = load i32, i32* <length field>
+ *   %ok = icmp ult i32 %index, %len          ; also rejects negative indices
+ *   br i1 %ok, label %bounds_ok_N, label %bounds_fail, !prof !0
+ * bounds_ok_N:
+ *   %elem = getelementptr { i32, [0 x T] }, { i32, [0 x T] }* %array, i32 0, i32 1, i32 %index
+ */
+std::string IR_Generator::gen_element_pointer(Node* node) {
+    Node* array_node = node->children[0];
+    std::string array_type = llvm_type(array_node->datatype);
+    std::string array = gen_expression(array_node);
+    std::string slot = spill(array, array_type, may_allocate(node->children[1]));
+    std::string index = gen_expression(node->children[1]);
+    array = reload(slot, array_type, array);
+    release(slot, array_type);
+    check_index(array_node, node->children[1], array, index);
+    return element_pointer(array_node->datatype, array, index);
+}
+
+void IR_Generator::check_index(Node* array_node, Node* index_node, const std::string &array,
+                               const std::string &index) {
+    if (index_in_bounds(array_node, index_node)) {
+        ++checks_removed;
+    } else {
+        bounds_check(array_node->datatype, array, index);
+    }
+}
+
+void IR_Generator::bounds_check(DataType datatype, const std::string &array, const std::string &index) {
+    std::string array_type = llvm_type(datatype);
+    std::string object_type = array_struct_type(element_type(datatype));
+    std::string length_pointer = new_tmp();
+    emit() << length_pointer << " = getelementptr " << object_type << ", " << array_type << " " << array
+           << ", i32 0, i32 0\n";
+    std::string length = new_tmp();
+    emit() << length << " = load i32, i32* " << length_pointer << "\n";
+    std::string in_bounds = new_tmp();
+    emit() << in_bounds << " = icmp ult i32 " << index << ", " << length << "\n";
+    std::string ok_label = new_label("bounds_ok");
+    // every check of the function shares the block calling llvm.trap, placed at its end
+    emit() << "br i1 " << in_bounds << ", label %" << ok_label << ", label %bounds_fail, !prof !0\n";
+    terminated = true;
+    ++checks_emitted;
+    emit_label(ok_label);
+}
+
+std::string IR_Generator::element_pointer(DataType datatype, const std::string &array, const std::string &index) {
+    std::string array_type = llvm_type(datatype);
+    std::string object_type = array_struct_type(element_type(datatype));
+    std::string pointer = new_tmp();
+    emit() << pointer << " = getelementptr " << object_type << ", " << array_type << " " << array
+           << ", i32 0, i32 1, i32 " << index << "\n";
+    return pointer;
+}
+
+/*
+ * store <type> <value>, <type>* %_root_N        ; a free slot of the same type, or a new root
+ */
+std::string IR_Generator::spill(const std::string &value, const std::string &type, bool needed) {
+    // constants (literals, null) are not in the heap
+    if (!frame || !needed || !is_heap_type(type) || value[0] != '%') return "";
+    std::vector<std::string> &free_slots = free_spill_slots[type];
+    std::string slot;
+    if (free_slots.empty()) {
+        std::string name = "_root_" + std::to_string(++spill_counter);
+        root_slots.emplace_back(name, type);
+        slot = "%" + name;
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    emit() << "store " << type << " " << value << ", " << type << "* " << slot << "\n";
+    return slot;
+}
+
+std::string IR_Generator::reload(const std::string &slot, const std::string &type, const std::string &value) {
+    if (slot.empty()) return value;
+    std::string tmp = new_tmp();
+    emit() << tmp << " = load " << type << ", " << type << "* " << slot << "\n";
+    return tmp;
+}
+
+void IR_Generator::release(const std::string &slot, const std::string &type) {
+    if (!slot.empty()) free_spill_slots[type].push_back(slot);
+}
+
+std::string IR_Generator::variable_pointer(Node* id_node) {
+    // the global scope has ID 1
+    return (id_node->scope_id == 1 ? "@" : "%") + id_node->unique_name();
+}
+
+/*
+ * @.str.N = private unnamed_addr constant { i32, i32, [len+1 x i8] } { i32 0, i32 len, [len+1 x i8] c"...\00" }
+ * The first two fields are the header of runtime strings, so the length is right before the characters.
+ * Escape sequences \n, \t, \\ and \" in the literal are decoded, the other bytes are kept as is.
+ * Literals are pooled by their bytes, so "\n" printed in a loop or in many functions is one constant.
+ */
+std::string IR_Generator::string_constant(const std::string &lexeme) {
+    std::string bytes;
+    for (size_t i = 0; i < lexeme.size(); ++i) {
+        char c = lexeme[i];
+        if (c == '\\' && i + 1 < lexeme.size()) {
+            char next = lexeme[i + 1];
+            if (next == 'n' || next == 't' || next == '\\' || next == '"') {
+                bytes += next == 'n' ? '\n' : next == 't' ? '\t' : next;
+                ++i;
+                continue;
+            }
+        }
+        bytes += c;
+    }
+    auto it = string_pool.find(bytes);
+    if (it != string_pool.end()) return it->second;
+
+    std::string name = "@.str." + std::to_string(string_pool.size() + 1);
+    std::string array_type = "[" + std::to_string(bytes.size() + 1) + " x i8]";
+    std::string object_type = "{ i32, i32, " + array_type + " }";
+    constants += name + " = private unnamed_addr constant " + object_type + " { i32 0, i32 "
+                 + std::to_string(bytes.size()) + ", " + array_type + " c\"";
+    for (unsigned char c : bytes) {
+        if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\') {
+            constants += (char)c;
+        } else {
+            char escaped[4];
+            snprintf(escaped, sizeof(escaped), "\\%02X", c);
+            constants += escaped;
+        }
+    }
+    constants += "\\00\" }\n";
+    std::string pointer = "getelementptr inbounds (" + object_type + ", " + object_type + "* " + name
+                          + ", i32 0, i32 2, i32 0)";
+    string_pool.emplace(std::move(bytes), pointer);
+    return pointer;
+}
+
+std::string IR_Generator::convert(const std::string &value, const std::string &from, const std::string &to) {
+    if (from == to) return value;
+    std::string tmp = new_tmp();
+    if (from == "i1" && to == "i32") {
+        emit() << tmp << " = zext i1 " << value << " to i32\n";
+    } else if (from.back() == '*' && to.back() == '*') {
+        emit() << tmp << " = bitcast " << from << " " << value << " to " << to << "\n";
+    } else {
+        std::cerr << "Error: cannot convert " << from << " to " << to << std::endl;
+        return value;
+    }
+    return tmp;
+}
+
+std::string IR_Generator::new_tmp() {
+    return "%_tmp_" + std::to_string(++tmp_counter);
+}
+
+std::string IR_Generator::new_label(const char* prefix) {
+    return std::string(prefix) + "_" + std::to_string(++label_counter);
+}
+
+OutputBuffer &IR_Generator::emit() {
+    if (terminated) {
+        // code after return is unreachable, but still needs a block to live in
+        emit_label(new_label("dead"));
+    }
+    return *body << '\t';
+}
+
+void IR_Generator::emit_label(const std::string &label) {
+    *body << label << ":\n";
+    current_block = label;
+    terminated = false;
+}
+
+void IR_Generator::emit_branch(const std::string &label) {
+    if (terminated) return;
+    *body << "\tbr label %" << label << "\n";
+    terminated = true;
+}
+
+void IR_Generator::emit_cond_branch(const std::string &cond, const std::string &true_label,
+                                    const std::string &false_label) {
+    if (terminated) return;
+    *body << "\tbr i1 " << cond << ", label %" << true_label << ", label %" << false_label << "\n";
+    terminated = true;
+}
@@ -0,0 +1,330 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 22nd, 2026
+ *
+ * This file defines the LLVM IR Generator class, which generates LLVM IR (.ll) from the analyzed AST
+ * natively, without Python and llvmlite.
+ */
+
+#ifndef CSC4180_IR_GENERATOR_HPP
+#define CSC4180_IR_GENERATOR_HPP
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "node.hpp"
+#include "output_buffer.hpp"
+
+/**
+ * LLVM IR Generator of Oat
+ *
+ * It takes the AST after semantic analysis, so every ID carries its unique name (lexeme-scope_id) and data type.
+ * The IR is LLVM 14 textual IR with typed pointers:
+ *   - int is i32, bool is i1, string is i8*
+ *   - an array is a pointer to { i32 length, [0 x element] }, so int[] has the layout of the runtime.c arrays
+ *   - globals are @<unique name>, locals are allocas %<unique name> placed in the entry block
+ *   - a string points at its NUL-terminated characters, with its i32 length cached 4 bytes before them
+ *   - string literals are pooled into private constants and used through pointers, never copied to the stack
+ * The runtime.c builtins are declared, and linked in from runtime.ll with llvm-link.
+ *
+ * Every array access is bounds checked, through one cold failure block per function. A check is removed when
+ * the index is provably in range: the array is a local always allocated with a constant length, and the index
+ * is a constant, or the variable of an enclosing counting for loop (plus or minus a constant).
+ *
+ * With gc, the IR is for the copying collector of runtime.c built with -DOAT_GC. Every function pushes a shadow
+ * stack frame { i8* prev, i32 count, [count x i8*] roots } onto @oat_gc_top, and its locals holding heap pointers
+ * live in the roots. A heap pointer held in a temporary is spilled to a root while a sibling operand that may
+ * allocate is evaluated, and read back afterwards, since the collector may have moved the object.
+ */
+class IR_Generator {
+public:
+    /**
+     * @param output: IR is appended to this buffer, pass a memory-mode OutputBuffer to keep the IR in memory
+     * @param gc: keep heap pointers in shadow stack roots for the copying collector
+     * @param jobs: number of threads generating functions, the IR is the same for any number
+     */
+    IR_Generator(OutputBuffer &output, bool gc = false, unsigned jobs = 1)
+        : out(output), gc(gc), jobs(jobs) {}
+
+    /**
+     * Export AST to LLVM IR file
+     *
+     * It emits the runtime declarations, then the global variables and functions in source order.
+     * The signatures of all functions and the string literal pool are built first, in one pass over the tree;
+     * after that a function only reads module-level state, so functions are generated on `jobs` threads,
+     * each into a buffer of its own, and the buffers are written in source order.
+     *
+     * @param node: root of the AST, semantic analysis must have been done
+     * @return
+     */
+    void export_ast_to_llvm_ir(Node* node);
+
+    int bounds_checks_emitted() const { return total_checks_emitted; }
+
+    int bounds_checks_removed() const { return total_checks_removed; }
+
+private:
+    /**
+     * Values of the variable of a counting for loop in its body and update
+     */
+    struct IndexRange {
+        std::string name;                           // unique name of the loop variable
+        int64_t low;
+        int64_t high;
+    };
+
+    /**
+     * LLVM types of a function
+     */
+    struct Signature {
+        std::string return_type;
+        std::vector<std::string> param_types;
+        std::string symbol;                         // called function, a builtin may map to another runtime one
+    };
+
+    /**
+     * Generator of functions on a worker thread, with its own copy of the signatures and the string literal pool
+     * @param module: generator of the module, after the signatures and string literals are collected
+     */
+    IR_Generator(const IR_Generator &module)
+        : out(module.out), gc(module.gc), jobs(1), functions(module.functions), string_pool(module.string_pool) {}
+
+    void declare_runtime_functions();
+
+    /**
+     * Intern every string literal of the program, in the order of the tree
+     */
+    void collect_string_literals(Node* node);
+
+    /**
+     * Generate functions on the worker threads, each takes the next function not taken yet
+     * @return the IR of every function, in the order of function_nodes
+     */
+    std::vector<std::unique_ptr<OutputBuffer>> gen_functions(const std::vector<Node*> &function_nodes);
+
+    void gen_global_decl(Node* node);
+
+    /**
+     * @param function_out: buffer the function definition is appended to
+     */
+    void gen_function_decl(Node* node, OutputBuffer &function_out);
+
+    /**
+     * Allocate the storage of a local variable in the entry block, a shadow stack root with gc for heap pointers
+     * @return false if the unique name is already allocated with another type
+     */
+    bool declare_local(const std::string &unique_name, const std::string &type);
+
+    /**
+     * Pop the shadow stack frame with gc, then return
+     * @param value: operand to return, empty for void
+     */
+    void emit_return(const std::string &value);
+
+    /**
+     * Find the local arrays of a function always allocated with a constant length, and the local ints
+     * always initialized to the same literal and never assigned
+     * @param node: function_decl node
+     */
+    void analyze_locals(Node* node);
+
+    /**
+     * @param value: set to the value of a constant int expression
+     * @return whether the expression is a literal, a negated literal, or a constant local int
+     */
+    bool constant_value(Node* node, int64_t &value);
+
+    /**
+     * Match for (var i = c0; i < c1; i = i + k;) with c0 >= 0, k > 0 and no other assignment to i
+     * @return whether the loop matched, range then holds the values of i in the body
+     */
+    bool loop_range(Node* node, IndexRange &range);
+
+    /**
+     * @return whether index_node is provably within [0, length of array_node) at this point
+     */
+    bool index_in_bounds(Node* array_node, Node* index_node);
+
+    void gen_statement(Node* node);
+
+    void gen_var_decl(Node* node);
+
+    void gen_assign(Node* node);
+
+    void gen_return(Node* node);
+
+    void gen_if(Node* node);
+
+    void gen_for(Node* node);
+
+    void gen_while(Node* node);
+
+    /**
+     * Generate the instructions of an expression
+     * @return the operand holding its value, of type llvm_type(node->datatype)
+     */
+    std::string gen_expression(Node* node);
+
+    /**
+     * Branch on an expression used as a condition
+     * & and | with side effects on the right become branch chains, ! swaps the targets
+     * @param true_label: target when the condition holds
+     * @param false_label: target otherwise
+     */
+    void gen_branch(Node* node, const std::string &true_label, const std::string &false_label);
+
+    std::string gen_binary(Node* node);
+
+    /**
+     * @param negate: produce the negated comparison, for !(a < b)
+     * @return the i1 result of a comparison
+     */
+    std::string gen_comparison(Node* node, bool negate);
+
+    /**
+     * & or | whose right operand has side effects, which is only evaluated when the left one does not decide
+     * @return the i1 result, merged with a phi
+     */
+    std::string gen_short_circuit(Node* node);
+
+    std::string gen_unary(Node* node);
+
+    /**
+     * Call a builtin or user function, arguments are converted to the parameter types
+     * @return the result operand, empty for void functions
+     */
+    std::string gen_call(Node* node);
+
+    /**
+     * length_of_string, a load of the length cached before the characters
+     * @param str: i8* operand
+     */
+    std::string gen_string_length(const std::string &str);
+
+    /**
+     * Allocate an array with the runtime allocator and store its length
+     * @param datatype: data type of the array
+     * @param length: i32 operand
+     * @return the array pointer
+     */
+    std::string gen_new_array(DataType datatype, const std::string &length);
+
+    /**
+     * Pointer to an element of an array, with a bounds check on the index
+     * @param node: array_index node
+     */
+    std::string gen_element_pointer(Node* node);
+
+    /**
+     * Bounds check of an array access, unless index_in_bounds() proves it is not needed
+     * @param array: array pointer operand
+     * @param index: i32 operand
+     */
+    void check_index(Node* array_node, Node* index_node, const std::string &array, const std::string &index);
+
+    /**
+     * Branch to the failure block unless 0 <= index < length of the array
+     * @param datatype: data type of the array
+     * @param array: array pointer operand
+     * @param index: i32 operand
+     */
+    void bounds_check(DataType datatype, const std::string &array, const std::string &index);
+
+    /**
+     * Pointer to an element of an array, without a bounds check
+     */
+    std::string element_pointer(DataType datatype, const std::string &array, const std::string &index);
+
+    /**
+     * (gc) Keep a heap pointer held in a temporary in a root slot while later operands are evaluated
+     * @param needed: whether something evaluated before the use may allocate
+     * @return the slot, empty if the value needs none
+     */
+    std::string spill(const std::string &value, const std::string &type, bool needed);
+
+    /**
+     * Read back a spilled value, the slot stays in use until release()
+     * @return the current value, or `value` itself if it was not spilled
+     */
+    std::string reload(const std::string &slot, const std::string &type, const std::string &value);
+
+    void release(const std::string &slot, const std::string &type);
+
+    /**
+     * @return the pointer operand of the storage of a resolved ID
+     */
+    std::string variable_pointer(Node* id_node);
+
+    /**
+     * Constant initializer of a global variable
+     * @return the constant operand, without its type
+     */
+    std::string gen_global_constant(Node* node, const std::string &name);
+
+    /**
+     * Intern a string literal into the module-level pool, equal literals share one private constant
+     * @return an i8* constant expression pointing at its first character
+     */
+    std::string string_constant(const std::string &lexeme);
+
+    /**
+     * Convert an operand between the Oat representation and a runtime parameter type (bool to i32, array to i32*)
+     */
+    std::string convert(const std::string &value, const std::string &from, const std::string &to);
+
+    std::string new_tmp();
+
+    std::string new_label(const char* prefix);
+
+    /**
+     * Emit one instruction into the current function, opening an unreachable block if the current one is closed
+     */
+    OutputBuffer &emit();
+
+    void emit_label(const std::string &label);
+
+    void emit_branch(const std::string &label);
+
+    void emit_cond_branch(const std::string &cond, const std::string &true_label, const std::string &false_label);
+
+private:
+    OutputBuffer &out;
+    bool gc;
+    unsigned jobs;
+    std::map<std::string, Signature> functions;     // function name -> LLVM signature
+    std::vector<std::string> global_roots;          // (gc) i8** constants of the global heap pointer locations
+    std::string constants;                          // string literal pool, emitted after the functions (not copied)
+    std::unordered_map<std::string, std::string> string_pool;  // literal bytes -> i8* constant expression
+    int total_checks_emitted = 0;
+    int total_checks_removed = 0;
+
+    /* state of the function being generated */
+    std::unique_ptr<OutputBuffer> body;             // instructions after the entry allocas
+    std::string allocas;                            // allocas of the entry block
+    std::string param_stores;                       // stores of the arguments into their allocas
+    std::map<std::string, std::string> locals;      // unique name -> LLVM type, already allocated
+    std::vector<std::pair<std::string, std::string>> root_slots;            // (gc) shadow stack roots, name and type
+    std::map<std::string, std::vector<std::string>> free_spill_slots;       // (gc) type -> spill slots not in use
+    int spill_counter = 0;
+    bool frame = false;                             // (gc) the function pushes a shadow stack frame
+    std::string return_type;
+    int tmp_counter = 0;
+    int label_counter = 0;
+    std::string current_block;                      // label of the block being generated, for phi
+    bool terminated = false;                        // the current block already ends with a terminator
+    std::map<std::string, int64_t> array_lengths;   // local array -> its smallest constant length
+    std::map<std::string, int64_t> int_constants;   // local int -> its only value
+    std::vector<IndexRange> loop_ranges;            // enclosing counting for loops
+    int checks_emitted = 0;
+    int checks_removed = 0;
+};
+
+#endif  // CSC4180_IR_GENERATOR_HPP
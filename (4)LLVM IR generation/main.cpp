@@ -11,12 +11,26 @@
  * This file defines the main function, which is the entrace to the Micro language compiler.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <cstdio>
 #include <cstring>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
 
+#include <sys/stat.h>
+
+#include "compile_cache.hpp"
+#include "flat_ast.hpp"
+#include "incremental_parser.hpp"
+#include "ir_generator.hpp"
 #include "node.hpp"
+#include "semantic_analyzer.hpp"
 
 extern int yyparse();
 
@@ -24,16 +38,248 @@ extern int yylex();
 
 extern Node* root_node;
 
+static bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool read_file(const std::string &filename, std::string &content) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+// the format an output file is written in, named by its extension, empty for an unknown extension
+static std::string output_kind(const std::string &filename) {
+    if (ends_with(filename, ".ast")) return "ast";
+    if (ends_with(filename, ".ll")) return "ll";
+    if (ends_with(filename, ".sym")) return "sym";
+    if (ends_with(filename, ".dot")) return "dot";
+    return "";
+}
+
+// whether an output needs the function bodies, only the .sym files do not
+static bool bodies_needed(const std::vector<std::string> &output_filenames) {
+    return std::any_of(output_filenames.begin(), output_filenames.end(),
+                       [](const std::string &filename) { return !ends_with(filename, ".sym"); });
+}
+
+// whether the program declares a function of that name
+static bool declares_function(Node* root, const std::string &name) {
+    return root != nullptr && std::any_of(root->children.begin(), root->children.end(), [&](Node* decl) {
+        return decl->symbol_class == SymbolClass::function_decl && decl->children[1]->lexeme == name;
+    });
+}
+
+/**
+ * Parse the function bodies a skim parse left out that the outputs need: every body for an output other than .sym,
+ * otherwise only the bodies of the functions whose calls the .sym files list
+ * @return root of the AST, null on a syntax error or if a dependency is not a function of the program
+ */
+static Node* parse_needed_bodies(IncrementalParser &parser, Node* root, const std::vector<std::string> &output_filenames,
+                                 const std::vector<std::string> &dependencies) {
+    if (root == nullptr) return nullptr;
+    if (bodies_needed(output_filenames)) return parser.parse_bodies();
+    for (auto &name : dependencies) {
+        if (!declares_function(root, name)) {
+            std::cerr << "Error: --deps " << name << " is not a function of the program\n";
+            return nullptr;
+        }
+        // a syntax error in the body is reported by yyerror
+        if (parser.parse_body(name) == nullptr) return nullptr;
+    }
+    return root;
+}
+
+/**
+ * Write every output file in the format its extension names
+ * @param root: root of the AST
+ * @param analyzed: whether semantic analysis passed, the .ll and .sym files are only written then
+ * @param output_filenames: .ast, .ll, .sym or .dot files
+ * @param gc: generate IR for the copying collector
+ * @param jobs: number of threads generating the functions of the IR
+ * @param dependencies: functions whose calls the .sym files list
+ */
+static void write_outputs(Node* root, bool analyzed, const std::vector<std::string> &output_filenames, bool gc,
+                          unsigned jobs, const std::vector<std::string> &dependencies) {
+    // flattened once for the .ast and .dot exporters, with the names and types resolved
+    FlatAst flat_ast(root);
+    for (auto &output_filename : output_filenames) {
+        if (ends_with(output_filename, ".ast")) {
+            OutputBuffer out(output_filename);
+            export_parse_tree_to_binary(flat_ast, out, analyzed ? AST_FLAG_ANALYZED : 0);
+        } else if (ends_with(output_filename, ".ll")) {
+            // IR generation needs the resolved names and types
+            if (!analyzed) continue;
+            OutputBuffer out(output_filename);
+            IR_Generator ir_generator(out, gc, jobs);
+            ir_generator.export_ast_to_llvm_ir(root);
+        } else if (ends_with(output_filename, ".sym")) {
+            if (!analyzed) continue;
+            OutputBuffer out(output_filename);
+            export_symbol_index(root, out, dependencies);
+        } else {
+            OutputBuffer out(output_filename);
+            export_parse_tree_to_dot(flat_ast, out);
+        }
+    }
+}
+
+/**
+ * Compile the source again every time it changes, until the process is stopped
+ * The file is polled every 100 ms. Only the tokens and declarations an edit touched are scanned and parsed again,
+ * semantic analysis and the outputs are redone in full; the token listing is not printed.
+ * With skim, function bodies are left out unless an output needs them.
+ */
+static void watch(const std::string &source_filename, const std::vector<std::string> &output_filenames, bool gc,
+                  unsigned jobs, bool skim, const std::vector<std::string> &dependencies) {
+    // the scanner prints its listing on stdout as it goes, which only the first compile would show in full
+    std::freopen("/dev/null", "w", stdout);
+    IncrementalParser parser(skim);
+    struct stat last = {};
+    std::string source;
+    for (bool first = true;; first = false) {
+        struct stat info;
+        while (stat(source_filename.c_str(), &info) != 0 || (!first && info.st_mtim.tv_sec == last.st_mtim.tv_sec &&
+               info.st_mtim.tv_nsec == last.st_mtim.tv_nsec && info.st_size == last.st_size)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        last = info;
+        if (!read_file(source_filename, source)) continue;
+        auto start = std::chrono::steady_clock::now();
+        Node* root = parser.update(source);
+        if (skim) root = parse_needed_bodies(parser, root, output_filenames, dependencies);
+        auto parsed = std::chrono::steady_clock::now();
+        Semantic_Analyzer analyzer;
+        bool analyzed = analyzer.analyze(root);
+        write_outputs(root, analyzed, output_filenames, gc, jobs, dependencies);
+        auto done = std::chrono::steady_clock::now();
+        auto &stats = parser.stats();
+        char line[200];
+        snprintf(line, sizeof(line), "%s: scanned %zu of %zu tokens, parsed %zu of %zu declarations in %.3f ms, "
+                 "analysis and outputs %.3f ms\n", source_filename.c_str(), stats.rescanned_tokens, stats.tokens,
+                 stats.reparsed_items, stats.items, std::chrono::duration<double, std::milli>(parsed - start).count(),
+                 std::chrono::duration<double, std::milli>(done - parsed).count());
+        std::cerr << line << std::flush;
+    }
+}
+
+static const char* const USAGE = "Usage: compiler <source.oat> [--gc] [-j jobs] [--cache <directory>] [--watch] [--skim] "
+                                 "[--deps <function>]... <output.ast|output.dot|output.ll|output.sym>...\n";
+
 int main(int argc, char const *argv[]) {
-    if (argc == 3) {
-        auto source_filename = std::string(argv[1]);
-        auto dot_filename = std::string(argv[2]);
-        freopen(source_filename.c_str(), "r", stdin);
-        yyparse();
-        export_parse_tree_to_dot(root_node, dot_filename);
+    // options may come anywhere, the first other argument is the source and the rest are outputs
+    std::string source_filename;
+    // --gc generates IR for the copying collector of runtime.c built with -DOAT_GC
+    bool gc = false;
+    // --watch compiles again on every change of the source, incrementally
+    bool watching = false;
+    // --skim parses the function bodies only if an output other than .sym needs them
+    bool skim = false;
+    // --deps lists the functions a function calls in the .sym files, with --skim only its body is parsed
+    std::vector<std::string> dependencies;
+    // -j sets the number of threads generating functions, one per core by default
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::unique_ptr<CompileCache> cache;
+    std::vector<std::string> output_filenames;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--gc") == 0) {
+            gc = true;
+        } else if (std::strcmp(argv[i], "--watch") == 0) {
+            watching = true;
+        } else if (std::strcmp(argv[i], "--skim") == 0) {
+            skim = true;
+        } else if (std::strcmp(argv[i], "--deps") == 0 && i + 1 < argc) {
+            dependencies.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache.reset(new CompileCache(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            std::cerr << "Error: unknown option or missing value: " << argv[i] << "\n" << USAGE;
+            return -1;
+        } else if (source_filename.empty()) {
+            source_filename = argv[i];
+        } else {
+            output_filenames.push_back(argv[i]);
+        }
+    }
+    if (source_filename.empty() || output_filenames.empty()) {
+        std::cerr << "Error: invalid number of arguments\n" << USAGE;
+        return -1;
+    }
+    // an output with another extension is more likely a misplaced source than a .dot file to overwrite
+    for (auto &output_filename : output_filenames) {
+        if (output_kind(output_filename).empty()) {
+            std::cerr << "Error: " << output_filename << " is not an .ast, .dot, .ll or .sym output\n" << USAGE;
+            return -1;
+        }
+    }
+    if (watching) {
+        watch(source_filename, output_filenames, gc, jobs, skim, dependencies);
+        return 0;
+    }
+    // the cache key holds everything that changes the outputs: --gc, --deps, the format of every output, and --skim
+    // when the bodies are not parsed, as errors in them are then not reported
+    std::string source;
+    std::string flags = gc ? "oat;gc" : "oat";
+    if (skim && !bodies_needed(output_filenames))
+        flags += ";skim";
+    for (auto &name : dependencies)
+        flags += ";deps=" + name;
+    for (auto &output_filename : output_filenames)
+        flags += ";" + output_kind(output_filename);
+    if (std::freopen(source_filename.c_str(), "r", stdin) == nullptr) {
+        std::cerr << "Error: cannot open " << source_filename << "\n";
+        return 1;
+    }
+    std::vector<CompileCache::Entry> entries;
+    if (cache && read_file(source_filename, source) && cache->lookup(source, flags, entries)) {
+        // scan anyway for the token listing on stdout, then skip parsing, analysis and IR generation
+        while (yylex() != 0) {}
+        for (size_t i = 0; i < output_filenames.size() && i < entries.size(); ++i) {
+            OutputBuffer out(output_filenames[i]);
+            out << entries[i].content;
+        }
         return 0;
+    }
+    Node* root = nullptr;
+    // owns the tree in skim mode
+    std::unique_ptr<IncrementalParser> skimmer;
+    if (skim) {
+        if (source.empty() && !read_file(source_filename, source)) {
+            std::cerr << "Error: cannot read " << source_filename << std::endl;
+            return 1;
+        }
+        skimmer.reset(new IncrementalParser(true));
+        root = parse_needed_bodies(*skimmer, skimmer->update(source), output_filenames, dependencies);
     } else {
-        std::cerr << "Error: invalid number of arguments\n";
-        return -1;
+        yyparse();
+        root = root_node;
+        for (auto &name : dependencies) {
+            if (root != nullptr && !declares_function(root, name)) {
+                std::cerr << "Error: --deps " << name << " is not a function of the program\n";
+                return 1;
+            }
+        }
+    }
+    // resolve names and types natively, a4.py then skips its own semantic analysis on the .ast file
+    Semantic_Analyzer analyzer;
+    bool analyzed = analyzer.analyze(root);
+    write_outputs(root, analyzed, output_filenames, gc, jobs, dependencies);
+    // only programs that pass semantic analysis are cached, the outputs are read back once written
+    if (cache && analyzed && !source.empty()) {
+        entries.clear();
+        bool complete = true;
+        for (auto &output_filename : output_filenames) {
+            CompileCache::Entry entry;
+            entry.name = output_kind(output_filename);
+            complete = complete && read_file(output_filename, entry.content);
+            entries.push_back(std::move(entry));
+        }
+        if (complete) cache->store(source, flags, entries);
     }
+    return analyzed ? 0 : 1;
 }
@@ -9,10 +9,14 @@
  * Email: yuxuanliu1@link.cuhk.edu.cn
  * 
  * This file defines some utility data structures and functions for tree node.
- * It also includes functions transferring tree into .dot file for graphviz visualization. 
+ * It also includes functions transferring tree into .dot file for graphviz visualization,
+ * and into the binary .ast file read by the backend.
  */
 
 #include "node.hpp"
+#include "flat_ast.hpp"
+
+#include <algorithm>
 
 std::string symbol_class_to_str(const SymbolClass &symbol_class) {
     switch (symbol_class) {
@@ -78,39 +82,146 @@ std::string symbol_class_to_str(const SymbolClass &symbol_class) {
     }
 }
 
-std::string escape_newlines(const std::string& s) {
-    std::string result;
-    for (char c : s) {
-        if (c == '\n') {
-            result += "\\n";
-        } else {
-            result += c;
+/**
+ * Write a string with every newline escaped as "\\n"
+ */
+static void write_escaped_newlines(OutputBuffer& out, const std::string& s) {
+    size_t start = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '\n') {
+            out.write(s.data() + start, i - start);
+            out << "\\n";
+            start = i + 1;
         }
     }
-    return result;
+    out.write(s.data() + start, s.size() - start);
 }
 
-void write_parse_tree(std::ofstream& out, Node* node, int& counter) {
-    if (node == nullptr) return;
-    // Create a unique identifier for the node
-    std::string node_id = "node" + std::to_string(counter++);
-    // Write the node
-    out << node_id << " [";
-    out << "label=\"" << escape_newlines(symbol_class_to_str(node->symbol_class)) << "\"";
-    out << ",lexeme=\"" << node->lexeme << "\"";
-    out << "];\n";
-    // Write connections to children
-    for (auto* child : node->children) {
-        std::string child_id = "node" + std::to_string(counter);
-        write_parse_tree(out, child, counter);
-        out << node_id << " -> " << child_id << ";\n";
+void write_parse_tree(OutputBuffer& out, const FlatAst& ast) {
+    // open holds the ancestors of the current node; an edge is written once the child's subtree is complete
+    std::vector<uint32_t> open;
+    auto close = [&]() {
+        uint32_t child = open.back();
+        open.pop_back();
+        if (!open.empty()) out << "node" << open.back() << " -> node" << child << ";\n";
+    };
+    for (uint32_t i = 0; i < ast.size(); ++i) {
+        while (!open.empty() && ast.subtree_end[open.back()] <= i) close();
+        out << "node" << i << " [";
+        out << "label=\"";
+        write_escaped_newlines(out, symbol_class_to_str(ast.symbol_class[i]));
+        out << "\"";
+        out << ",lexeme=\"";
+        out.write(ast.strings.data() + ast.lexeme_offset[i], ast.lexeme_length[i]);
+        out << "\"";
+        out << "];\n";
+        open.push_back(i);
     }
+    while (!open.empty()) close();
 }
 
 void export_parse_tree_to_dot(Node* root, const std::string& filename) {
-    std::ofstream out(filename);
+    OutputBuffer out(filename);
+    export_parse_tree_to_dot(FlatAst(root), out);
+}
+
+void export_parse_tree_to_dot(Node* root, OutputBuffer& out) {
+    export_parse_tree_to_dot(FlatAst(root), out);
+}
+
+void export_parse_tree_to_dot(const FlatAst& ast, OutputBuffer& out) {
     out << "digraph AST {\n";
-    int counter = 0;
-    write_parse_tree(out, root, counter);
+    write_parse_tree(out, ast);
     out << "}";
 }
+
+// little-endian, independent of the host
+static void append_u32(std::string& bytes, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8)
+        bytes.push_back((char)((value >> shift) & 0xff));
+}
+
+void export_parse_tree_to_binary(Node* root, const std::string& filename, uint32_t flags) {
+    OutputBuffer out(filename);
+    export_parse_tree_to_binary(FlatAst(root), out, flags);
+}
+
+void export_parse_tree_to_binary(Node* root, OutputBuffer& out, uint32_t flags) {
+    export_parse_tree_to_binary(FlatAst(root), out, flags);
+}
+
+void export_parse_tree_to_binary(const FlatAst& ast, OutputBuffer& out, uint32_t flags) {
+    std::string header("OATAST\0", 7);
+    header.push_back((char)AST_FORMAT_VERSION);
+    append_u32(header, ast.size());
+    append_u32(header, ast.strings.size());
+    append_u32(header, flags);
+    // node records, a forward scan over the arrays
+    std::string records;
+    records.reserve(20 * ast.size());
+    for (uint32_t i = 0; i < ast.size(); ++i) {
+        records.push_back((char)ast.symbol_class[i]);
+        records.push_back((char)ast.datatype[i]);
+        records.append(2, '\0');
+        append_u32(records, ast.child_count(i));
+        append_u32(records, ast.lexeme_offset[i]);
+        append_u32(records, ast.lexeme_length[i]);
+        append_u32(records, ast.scope_id[i]);
+    }
+    out << header << records << ast.strings;
+}
+
+// type names as written in Oat source
+static const char* datatype_to_str(DataType datatype) {
+    switch (datatype) {
+        case DataType::INT: return "int";
+        case DataType::BOOL: return "bool";
+        case DataType::STRING: return "string";
+        case DataType::INT_ARRAY: return "int[]";
+        case DataType::BOOL_ARRAY: return "bool[]";
+        case DataType::STRING_ARRAY: return "string[]";
+        case DataType::VOID: return "void";
+        default: return "?";
+    }
+}
+
+/**
+ * @return the names of the functions called in a subtree, in order of their first call
+ */
+static std::vector<std::string> called_functions(Node* node) {
+    std::vector<std::string> callees;
+    // pre-order with an explicit stack, children pushed last to first
+    std::vector<Node*> stack = {node};
+    while (!stack.empty()) {
+        Node* current = stack.back();
+        stack.pop_back();
+        if (current == nullptr) continue;
+        if (current->symbol_class == SymbolClass::func_call) {
+            const std::string &callee = current->children[0]->lexeme;
+            if (std::find(callees.begin(), callees.end(), callee) == callees.end()) callees.push_back(callee);
+        }
+        stack.insert(stack.end(), current->children.rbegin(), current->children.rend());
+    }
+    return callees;
+}
+
+void export_symbol_index(Node* root, OutputBuffer& out, const std::vector<std::string>& dependencies) {
+    if (root == nullptr) return;
+    for (Node* decl : root->children) {
+        if (decl->symbol_class == SymbolClass::global_decl) {
+            out << "global " << decl->children[0]->lexeme << " " << datatype_to_str(decl->datatype) << "\n";
+        } else if (decl->symbol_class == SymbolClass::function_decl) {
+            out << "function " << decl->children[1]->lexeme << " " << datatype_to_str(decl->children[0]->datatype) << "(";
+            const std::vector<Node*> &args = decl->children[2]->children;
+            for (size_t i = 0; i < args.size(); ++i)
+                out << (i == 0 ? "" : ", ") << datatype_to_str(args[i]->datatype);
+            out << ")\n";
+            const std::string &name = decl->children[1]->lexeme;
+            if (std::find(dependencies.begin(), dependencies.end(), name) == dependencies.end()) continue;
+            out << "calls " << name;
+            for (auto &callee : called_functions(decl->children[3]))
+                out << " " << callee;
+            out << "\n";
+        }
+    }
+}
@@ -9,7 +9,8 @@
  * Email: yuxuanliu1@link.cuhk.edu.cn
  * 
  * This file defines some utility data structures and functions for tree node.
- * It also includes functions transferring tree into .dot file for graphviz visualization. 
+ * It also includes functions transferring tree into .dot file for graphviz visualization,
+ * and into the binary .ast file read by the backend.
  */
 
 #ifndef CSC4180_NODE_HPP
@@ -17,9 +18,12 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "output_buffer.hpp"
+
 /**
  * Define all classes of symbols for Micro language,
  * including both tokens (terminal symbols) and non-terminal symbols
@@ -93,6 +97,21 @@ enum class SymbolClass {
  */
 std::string symbol_class_to_str(const SymbolClass &symbol_class);
 
+/**
+ * Data types of Oat, filled in by semantic analysis
+ * The values are the same as DataType in a4.py, they are stored as is in the .ast file.
+ */
+enum class DataType : uint8_t {
+    INT = 1,            // 32-bit integer
+    BOOL,
+    STRING,
+    INT_ARRAY,
+    BOOL_ARRAY,
+    STRING_ARRAY,
+    VOID,
+    NONE,               // not typed (statements), or not analyzed yet
+};
+
 /**
  * Basic data structure for tree-structure
  */
@@ -100,6 +119,16 @@ struct Node {
     SymbolClass symbol_class;
     std::string lexeme;
     std::vector<Node*> children;
+    DataType datatype = DataType::NONE;
+    uint32_t scope_id = 0;      // for ID: scope the identifier resolves to, 0 if not resolved
+
+    /**
+     * Unique name of a resolved identifier, used for IR codegen
+     * @return lexeme + "-" + scope id, the same as SymbolTable.unique_name in a4.py
+     */
+    std::string unique_name() const {
+        return lexeme + "-" + std::to_string(scope_id);
+    }
 
     Node(const SymbolClass &symbol, std::string label = "") {
         symbol_class = symbol;
@@ -120,22 +149,99 @@ struct Node {
     }
 };
 
+struct FlatAst;
+
 /**
- * [Recursive] Write tree structure as Dot content and output as file stream
- * @param out: output file stream
- * @param node
- * @param counter: node counter
+ * Write tree structure as Dot content and output as file stream
+ * The flat tree is in pre-order, so node ids are indices and the tree is written in one forward scan
+ * @param out: output buffer
+ * @param ast: the tree to write
  * @return
  */
-void write_parse_tree(std::ofstream& out, Node* node, int& counter);
+void write_parse_tree(OutputBuffer& out, const FlatAst& ast);
 
 /**
  * Export tree structure as a Dot file for visualization
- * It calls the recursive write_parse_tree function.
+ * It flattens the tree and calls write_parse_tree.
  * @param root: the root node of the tree to export
  * @param filename: filename to write to
  * @return
  */
 void export_parse_tree_to_dot(Node* root, const std::string& filename);
 
+/**
+ * Export tree structure as Dot content into an output buffer
+ * @param root: the root node of the tree to export
+ * @param out: output buffer, either file-backed or in memory
+ * @return
+ */
+void export_parse_tree_to_dot(Node* root, OutputBuffer& out);
+
+/**
+ * Export a flattened tree as Dot content into an output buffer
+ * @param ast: the tree to export
+ * @param out: output buffer, either file-backed or in memory
+ * @return
+ */
+void export_parse_tree_to_dot(const FlatAst& ast, OutputBuffer& out);
+
+/**
+ * Binary AST format (.ast), loaded by a4.py with a single read instead of parsing the .dot text
+ *
+ *   header:        8-byte magic "OATAST\0" + version byte, u32 node count, u32 string table size, u32 flags
+ *   node records:  u8 symbol class, u8 data type, 2 padding bytes,
+ *                  u32 child count, u32 lexeme offset, u32 lexeme length, u32 scope id
+ *   string table:  lexemes referenced by the records, each distinct lexeme stored once
+ *
+ * Records are in pre-order (the same order as the node ids in the .dot file), so the children of a node
+ * follow it directly. Integers are little-endian, the symbol class is the SymbolClass value.
+ * With AST_FLAG_ANALYZED the data types and scope ids come from semantic analysis, otherwise they are NONE and 0.
+ */
+const int AST_FORMAT_VERSION = 2;
+const uint32_t AST_FLAG_ANALYZED = 1;
+
+/**
+ * Export tree structure as a binary .ast file
+ * @param root: the root node of the tree to export
+ * @param filename: filename to write to
+ * @param flags: AST_FLAG_ANALYZED if semantic analysis has been done on the tree
+ * @return
+ */
+void export_parse_tree_to_binary(Node* root, const std::string& filename, uint32_t flags = 0);
+
+/**
+ * Export tree structure in the binary .ast format into an output buffer
+ * @param root: the root node of the tree to export
+ * @param out: output buffer, either file-backed or in memory
+ * @param flags: AST_FLAG_ANALYZED if semantic analysis has been done on the tree
+ * @return
+ */
+void export_parse_tree_to_binary(Node* root, OutputBuffer& out, uint32_t flags = 0);
+
+/**
+ * Export a flattened tree in the binary .ast format into an output buffer
+ * The records are the arrays of the FlatAst in the same order, and its string table is written as is.
+ * @param ast: the tree to export
+ * @param out: output buffer, either file-backed or in memory
+ * @param flags: AST_FLAG_ANALYZED if semantic analysis has been done on the tree
+ * @return
+ */
+void export_parse_tree_to_binary(const FlatAst& ast, OutputBuffer& out, uint32_t flags = 0);
+
+/**
+ * Export the symbol index (.sym) of an analyzed tree: one line per top-level declaration, in source order,
+ *
+ *   global <name> <type>
+ *   function <name> <return type>(<argument types>)
+ *   calls <name> <callee>...        after the function line, for the functions named in dependencies
+ *
+ * with types written as in Oat, e.g. `function main int(int, string[])`, and the callees in order of their first
+ * call. Only the declarations and the bodies of the dependencies are read, so the tree may come from a skim parse.
+ * @param root: the root node of the analyzed tree
+ * @param out: output buffer, either file-backed or in memory
+ * @param dependencies: names of the functions whose calls are listed
+ * @return
+ */
+void export_symbol_index(Node* root, OutputBuffer& out, const std::vector<std::string>& dependencies = {});
+
 #endif  // CSC4180_NODE_HPP
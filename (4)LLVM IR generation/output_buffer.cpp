@@ -0,0 +1,165 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 19th, 2026
+ *
+ * This file implements the OutputBuffer class defined in output_buffer.hpp
+ */
+
+#include "output_buffer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// "00" "01" ... "99", two digits are emitted per division
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+OutputBuffer::OutputBuffer()
+    : fd(-1), owns_fd(false), pos(0), total_bytes(0) {
+    chunks.push_back(new char[CHUNK_SIZE]);
+}
+
+OutputBuffer::OutputBuffer(const std::string &filename)
+    : OutputBuffer() {
+    if (filename == "-") {
+        fd = STDOUT_FILENO;
+        return;
+    }
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: cannot open " << filename << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    owns_fd = true;
+}
+
+OutputBuffer::~OutputBuffer() {
+    close();
+    for (auto chunk : chunks)
+        delete[] chunk;
+}
+
+void OutputBuffer::write(const char *data, size_t len) {
+    total_bytes += len;
+    while (len > 0) {
+        if (pos == CHUNK_SIZE) new_chunk();
+        size_t n = std::min(len, CHUNK_SIZE - pos);
+        std::memcpy(chunks.back() + pos, data, n);
+        pos += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void OutputBuffer::write_int(long long value) {
+    char buf[24];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    // work on the magnitude as unsigned to handle LLONG_MIN
+    unsigned long long v = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    while (v >= 100) {
+        unsigned idx = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--p = DIGIT_PAIRS[idx + 1];
+        *--p = DIGIT_PAIRS[idx];
+    }
+    if (v >= 10) {
+        unsigned idx = (unsigned)v * 2;
+        *--p = DIGIT_PAIRS[idx + 1];
+        *--p = DIGIT_PAIRS[idx];
+    } else {
+        *--p = (char)('0' + v);
+    }
+    if (value < 0) *--p = '-';
+    write(p, end - p);
+}
+
+OutputBuffer &OutputBuffer::operator<<(const char *s) {
+    write(s, std::strlen(s));
+    return *this;
+}
+
+OutputBuffer &OutputBuffer::operator<<(char c) {
+    if (pos == CHUNK_SIZE) new_chunk();
+    chunks.back()[pos++] = c;
+    ++total_bytes;
+    return *this;
+}
+
+// Start a new chunk, flushing first if enough chunks are pending in file mode
+void OutputBuffer::new_chunk() {
+    if (fd >= 0 && chunks.size() >= FLUSH_CHUNKS) {
+        flush();
+        return;
+    }
+    chunks.push_back(new char[CHUNK_SIZE]);
+    pos = 0;
+}
+
+void OutputBuffer::flush() {
+    if (fd < 0) return;
+    std::vector<struct iovec> iov(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        iov[i].iov_base = chunks[i];
+        iov[i].iov_len = (i + 1 == chunks.size()) ? pos : CHUNK_SIZE;
+    }
+    // writev may write partially, advance through the iovec array until everything is out
+    size_t first = 0;
+    while (first < iov.size()) {
+        if (iov[first].iov_len == 0) { ++first; continue; }
+        ssize_t n = ::writev(fd, &iov[first], (int)std::min<size_t>(iov.size() - first, IOV_MAX));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: write failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        while (n > 0) {
+            size_t step = std::min((size_t)n, iov[first].iov_len);
+            iov[first].iov_base = (char *)iov[first].iov_base + step;
+            iov[first].iov_len -= step;
+            n -= step;
+            if (iov[first].iov_len == 0) ++first;
+        }
+    }
+    // keep the first chunk for reuse
+    for (size_t i = 1; i < chunks.size(); ++i)
+        delete[] chunks[i];
+    chunks.resize(1);
+    pos = 0;
+}
+
+void OutputBuffer::close() {
+    if (fd < 0) return;
+    flush();
+    if (owns_fd) ::close(fd);
+    fd = -1;
+    owns_fd = false;
+}
+
+std::string OutputBuffer::str() const {
+    std::string result;
+    result.reserve((chunks.size() - 1) * CHUNK_SIZE + pos);
+    for (size_t i = 0; i < chunks.size(); ++i)
+        result.append(chunks[i], (i + 1 == chunks.size()) ? pos : CHUNK_SIZE);
+    return result;
+}
@@ -26,8 +26,15 @@ int yyerror (char *s);
 
 int yylex();
 
+// where the parser takes its tokens from: the scanner, or the recorded tokens incremental_parser.cpp replays
+int (*token_source)() = yylex;
+#define yylex() token_source()
+
 Node* root_node = nullptr;
 
+// the parser stacks are on the heap and double when full, let deeply nested expressions grow them
+// far beyond bison's default of 10000 levels
+#define YYMAXDEPTH 100000000
 %}
 
 // yylval data types
@@ -47,7 +54,6 @@ Node* root_node = nullptr;
 // Binary Operator Symbols
 // precedence declaration from low to high
 %left LPAREN RPAREN
-%left LBRACKET RBRACKET
 %left LBRACE RBRACE
 %left BOR                          // precedence: 20
 %left BAND                         // precedence: 30
@@ -61,6 +67,7 @@ Node* root_node = nullptr;
 
 // Unary Operator Symbols
 %left UMINUS                       // unary MINUS. Unary operators should have higher precedence than binary operators, otherwise, shift-reduce conflicts occur
+%left LBRACKET RBRACKET            // array indexing binds tighter than any operator: -a[i] is -(a[i]), s + a[i] is s + (a[i])
 %token NOT
 %token TILDE
 
@@ -68,11 +75,11 @@ Node* root_node = nullptr;
 %start start
 
 // Non-Terminal Symbols
-%type <node> program decl global_decl function_decl var_decl var_decls var_decls_follow
+%type <node> program decl global_decl function_decl var_decl var_decls var_decl_list
 
-%type <node> exp exp_opt exps exps_follow global_exp global_exps global_exps_follow
+%type <node> exp exp_opt exps exp_list global_exp global_exps global_exp_list
 
-%type <node> arg args args_follow block stmt stmt_opt stmts lhs if_stmt else_stmt type ref
+%type <node> arg args arg_list block stmt stmt_opt stmts lhs if_stmt else_stmt type ref
 
 %%
 
@@ -85,14 +92,10 @@ Node* root_node = nullptr;
 start           : program SCANEOF { root_node = $1; };
 
 program         : %empty { $$ = nullptr; }
-                | decl program {
-                    // flatten the AST
-                    $$ = new Node(SymbolClass::program);
-                    $$->append_child($1);
-                    if ($2 != nullptr) {
-                        for (auto child : $2->children)
-                            $$->append_child(child);
-                    }
+                | program decl {
+                    // left recursion: the flattened AST grows in place, one append per declaration
+                    $$ = ($1 != nullptr) ? $1 : new Node(SymbolClass::program);
+                    $$->append_child($2);
                 };
 
 decl            : global_decl { $$ = $1; }
@@ -119,35 +122,23 @@ arg             : type ID {
                 };
 
 args            : %empty { $$ = new Node(SymbolClass::args); }
-                | arg args_follow {
-                    $$ = new Node(SymbolClass::args);
-                    $$->append_child($1);
-                    if ($2 != nullptr) {
-                        for (auto child : $2->children)
-                            $$->append_child(child);
-                    }
-                };
+                | arg_list { $$ = $1; };
 
-args_follow     : %empty { $$ = nullptr; }
-                | COMMA arg args_follow {
+arg_list        : arg {
                     $$ = new Node(SymbolClass::args);
-                    $$->append_child($2);
-                    if ($3 != nullptr) {
-                        for (auto child : $3->children)
-                            $$->append_child(child);
-                    }
+                    $$->append_child($1);
+                }
+                | arg_list COMMA arg {
+                    $$ = $1;
+                    $$->append_child($3);
                 };
 
 block           : LBRACE stmts RBRACE { $$ = $2; };
 
 stmts           : %empty { $$ = new Node(SymbolClass::stmts); }
-                | stmt stmts {
-                    $$ = new Node(SymbolClass::stmts);
-                    $$->append_child($1);
-                    if ($2 != nullptr) {
-                        for (auto child : $2->children)
-                            $$->append_child(child);
-                    }
+                | stmts stmt {
+                    $$ = $1;
+                    $$->append_child($2);
                 };
 
 type            : TINT { $$ = new Node(SymbolClass::TINT); }
@@ -161,25 +152,17 @@ ref             : TSTRING { $$ = new Node(SymbolClass::TSTRING); }
                 };
 
 global_exps     : %empty { $$ = nullptr; }
-                | global_exp global_exps_follow {
+                | global_exp_list { $$ = $1; };
+
+global_exp_list : global_exp {
                     $$ = new Node(SymbolClass::global_exps);
                     $$->append_child($1);
-                    if ($2 != nullptr) {
-                        for (auto child : $2->children)
-                            $$->append_child(child);
-                    }
+                }
+                | global_exp_list COMMA global_exp {
+                    $$ = $1;
+                    $$->append_child($3);
                 };
 
-global_exps_follow  : %empty { $$ = nullptr; }
-                    | COMMA global_exp global_exps_follow {
-                        $$ = new Node(SymbolClass::global_exps);
-                        $$->append_child($2);
-                        if ($3 != nullptr) {
-                            for (auto child : $3->children)
-                                $$->append_child(child);
-                        }
-                    };
-
 global_exp      : INTLITERAL { $$ = new Node(SymbolClass::INTLITERAL, std::to_string($1)); }
                 | STRINGLITERAL { $$ = new Node(SymbolClass::STRINGLITERAL, *$1); }
                 | TRUE_ { $$ = new Node(SymbolClass::TRUE); }
@@ -251,25 +234,17 @@ lhs             : ID { $$ = new Node(SymbolClass::ID, *$1); }
                 };
 
 var_decls       : %empty { $$ = nullptr; }
-                | var_decl var_decls_follow {
+                | var_decl_list { $$ = $1; };
+
+var_decl_list   : var_decl {
                     $$ = new Node(SymbolClass::var_decls);
                     $$->append_child($1);
-                    if ($2 != nullptr) {
-                        for (auto child : $2->children)
-                            $$->append_child(child);
-                    }
+                }
+                | var_decl_list COMMA var_decl {
+                    $$ = $1;
+                    $$->append_child($3);
                 };
 
-var_decls_follow    : %empty { $$ = nullptr; }
-                    | COMMA var_decl var_decls_follow {
-                        $$ = new Node(SymbolClass::var_decls);
-                        $$->append_child($2);
-                        if ($3 == nullptr) {
-                            for (auto child : $3->children)
-                                $$->append_child(child);
-                        }
-                    };
-
 var_decl        : VAR ID ASSIGN exp {
                     $$ = new Node(SymbolClass::var_decl);
                     $$->append_child(new Node(SymbolClass::ID, *$2));
@@ -277,23 +252,15 @@ var_decl        : VAR ID ASSIGN exp {
                 };
 
 exps            : %empty { $$ = nullptr; }
-                | exp exps_follow {
-                    $$ = new Node(SymbolClass::exps);
-                    $$->append_child($1);
-                    if ($2 != nullptr) {
-                        for (auto child : $2->children)
-                            $$->append_child(child);
-                    }
-                };
+                | exp_list { $$ = $1; };
 
-exps_follow     : %empty { $$ = nullptr; }
-                | COMMA exp exps_follow {
+exp_list        : exp {
                     $$ = new Node(SymbolClass::exps);
-                    $$->append_child($2);
-                    if ($3 != nullptr) {
-                        for (auto child : $3->children)
-                            $$->append_child(child);
-                    }
+                    $$->append_child($1);
+                }
+                | exp_list COMMA exp {
+                    $$ = $1;
+                    $$->append_child($3);
                 };
 
 exp             : ID { $$ = new Node(SymbolClass::ID, *$1); }
@@ -13,37 +13,363 @@
 #include <assert.h>
 #include <string.h>
 #include <stdint.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+/* Oat Memory Allocation ---------------------------------------------------- */
+
+/*
+ * Every Oat array and string is allocated by oat_alloc_bytes, zero-filled, after an 8-byte header.
+ * A string points at its characters, still NUL-terminated for printf, and its length is cached in the header
+ * right before them (the string literals emitted by the compiler have the same layout), so strings built by
+ * the runtime never need strlen. Three builds are supported:
+ *   - default:     calloc, nothing is ever freed
+ *   - -DOAT_ARENA: a thread-local bump arena carved out of large mmap'd chunks, nothing is ever freed
+ *   - -DOAT_GC:    a semi-space copying collector over mmap'd spaces, for programs compiled with
+ *                  `compiler --gc`, whose functions keep their heap pointers in shadow stack frames
+ */
+
+#define OAT_KIND_BYTES 0      /* strings, int[] and bool[]: no pointers inside */
+#define OAT_KIND_POINTERS 1   /* string[]: { i32 length, [length x i8*] }, the elements start at offset 8 */
+
+typedef struct {
+  uint32_t info;              /* (gc) payload bytes, a multiple of 8, | kind << 1 */
+  int32_t length;             /* strings: number of characters */
+} oat_header;
+
+#define OAT_HEADER(p) ((oat_header*)(p) - 1)
+
+#if defined(OAT_ARENA) || defined(OAT_GC)
+
+#include <sys/mman.h>
+
+#define OAT_CHUNK_SIZE ((size_t)1 << 20)
+
+static char* oat_map(size_t size) {
+  void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    fprintf(stderr, "Error: out of memory\n");
+    exit(1);
+  }
+  return (char*)p;
+}
+
+#endif
+
+#if defined(OAT_GC)
+
+/*
+ * When an object is copied, its header is overwritten by the address of the copy with the lowest bit set
+ * (a real header has an even info there, on little-endian targets). The payload is left intact, so a runtime
+ * function still reads its arguments after a collection, but it must read their lengths before allocating.
+ */
+#define OAT_INFO_SIZE(info) ((info) & ~(uint32_t)7)
+#define OAT_INFO_POINTERS(info) (((info) >> 1) & OAT_KIND_POINTERS)
+
+/*
+ * Shadow stack frame pushed by every function compiled with --gc, { i8*, i32, [count x i8*] } in the IR.
+ * roots are the slots of its local variables and spilled temporaries holding heap pointers.
+ */
+typedef struct oat_gc_frame {
+  struct oat_gc_frame* prev;
+  int32_t count;
+  void* roots[];
+} oat_gc_frame;
+
+oat_gc_frame* oat_gc_top = NULL;
+
+/* Emitted by the compiler: addresses of the global variables (and static array elements) holding heap pointers */
+extern int32_t oat_gc_global_count;
+extern void** oat_gc_globals[];
+
+/*
+ * The collector stops the world of a single Oat thread, so its state is not thread-local.
+ * Objects are allocated in [from_start, from_end), to_start is the other space of the same size.
+ */
+static char* from_start = NULL;
+static char* from_end = NULL;
+static char* to_start = NULL;
+static size_t space_size = 0;
+static char* alloc_next = NULL;
+static char* copy_next = NULL;
+static char* retired = NULL;      /* old from-space after growing, unmapped at the next collection */
+static size_t retired_size = 0;
+
+static void* oat_gc_forward(void* p) {
+  char* object = (char*)p;
+  /* string literals and the static arrays of global initializers are not in the heap */
+  if (object < from_start || object >= from_end) return p;
+  oat_header* header = OAT_HEADER(object);
+  uintptr_t word;
+  memcpy(&word, header, sizeof(word));
+  if (word & 1) return (void*)(word - 1);
+  size_t total = sizeof(oat_header) + OAT_INFO_SIZE(header->info);
+  oat_header* copy = (oat_header*)copy_next;
+  memcpy(copy, header, total);
+  copy_next += total;
+  word = (uintptr_t)(copy + 1) | 1;
+  memcpy(header, &word, sizeof(word));
+  return copy + 1;
+}
+
+/*
+ * Cheney copy of everything reachable from the roots out of [from_start, from_end) into dest
+ * @return the end of the copied objects
+ */
+static char* oat_gc_copy(char* dest) {
+  copy_next = dest;
+  for (oat_gc_frame* frame = oat_gc_top; frame != NULL; frame = frame->prev) {
+    for (int32_t i = 0; i < frame->count; i++) {
+      frame->roots[i] = oat_gc_forward(frame->roots[i]);
+    }
+  }
+  for (int32_t i = 0; i < oat_gc_global_count; i++) {
+    *oat_gc_globals[i] = oat_gc_forward(*oat_gc_globals[i]);
+  }
+  char* scan = dest;
+  while (scan < copy_next) {
+    oat_header* header = (oat_header*)scan;
+    if (OAT_INFO_POINTERS(header->info)) {
+      char* array = (char*)(header + 1);
+      int32_t length = *(int32_t*)array;
+      void** elements = (void**)(array + 8);
+      for (int32_t i = 0; i < length; i++) {
+        elements[i] = oat_gc_forward(elements[i]);
+      }
+    }
+    scan += sizeof(oat_header) + OAT_INFO_SIZE(header->info);
+  }
+  return copy_next;
+}
+
+/*
+ * Make room for an object of `request` bytes (header included)
+ * The live objects are copied to the other space. If they fill more than half of it, both spaces are
+ * replaced by larger ones and the live objects are copied once more.
+ * The old from-space is kept until the next collection: the runtime function that is allocating
+ * may still read its arguments from there.
+ */
+static void oat_gc_collect(size_t request) {
+  if (from_start == NULL) {
+    space_size = OAT_CHUNK_SIZE;
+    while (request > space_size / 2) space_size *= 2;
+    from_start = oat_map(space_size);
+    from_end = from_start + space_size;
+    to_start = oat_map(space_size);
+    alloc_next = from_start;
+    return;
+  }
+  if (retired != NULL) {
+    munmap(retired, retired_size);
+    retired = NULL;
+  }
+  char* old_from = from_start;
+  alloc_next = oat_gc_copy(to_start);
+  from_start = to_start;
+  from_end = to_start + space_size;
+  to_start = old_from;
+  size_t live = alloc_next - from_start;
+  if (live + request > space_size / 2) {
+    size_t new_size = space_size * 2;
+    while (live + request > new_size / 2) new_size *= 2;
+    char* dest = oat_map(new_size);
+    alloc_next = oat_gc_copy(dest);
+    munmap(from_start, space_size);
+    retired = to_start;
+    retired_size = space_size;
+    space_size = new_size;
+    from_start = dest;
+    from_end = dest + new_size;
+    to_start = oat_map(new_size);
+  }
+}
+
+static void* oat_alloc_bytes(size_t size, int32_t kind) {
+  size_t payload = (size + 7) & ~(size_t)7;
+  size_t total = sizeof(oat_header) + payload;
+  if (alloc_next == NULL || total > (size_t)(from_end - alloc_next)) oat_gc_collect(total);
+  oat_header* header = (oat_header*)alloc_next;
+  alloc_next += total;
+  header->info = (uint32_t)payload | (uint32_t)kind << 1;
+  header->length = 0;
+  /* the space may hold objects of an earlier cycle */
+  memset(header + 1, 0, payload);
+  return header + 1;
+}
+
+#elif defined(OAT_ARENA)
+
+static _Thread_local char* arena_next = NULL;
+static _Thread_local char* arena_end = NULL;
+
+static void* oat_alloc_bytes(size_t size, int32_t kind) {
+  (void)kind;
+  size = sizeof(oat_header) + ((size + 7) & ~(size_t)7);
+  if (size > (size_t)(arena_end - arena_next)) {
+    /* the rest of the current chunk is abandoned, a large object gets a chunk of its own */
+    size_t chunk = size > OAT_CHUNK_SIZE ? size : OAT_CHUNK_SIZE;
+    arena_next = oat_map(chunk);
+    arena_end = arena_next + chunk;
+  }
+  oat_header* header = (oat_header*)arena_next;   /* fresh mmap'd memory is already zero */
+  arena_next += size;
+  return header + 1;
+}
+
+#else
+
+static void* oat_alloc_bytes(size_t size, int32_t kind) {
+  (void)kind;
+  oat_header* header = (oat_header*)calloc(sizeof(oat_header) + size, sizeof(char));
+  assert (NULL != header);
+  return header + 1;
+}
+
+#endif
+
+/* Oat Output --------------------------------------------------------------- */
+
+/*
+ * print_* append to a buffer of the calling thread instead of going through printf, so there is neither
+ * stdio locking nor format parsing. The buffer is written out when full, at exit, and after each newline
+ * when stdout is a terminal (like stdio). A thread other than the main one calls oat_flush before it ends.
+ */
+#define OAT_OUTPUT_SIZE ((size_t)1 << 16)
+#define OAT_INT_DIGITS 11     /* "-2147483648" */
+
+typedef struct {
+  size_t used;
+  int line_buffered;          /* -1 until the first print of the thread */
+  char data[OAT_OUTPUT_SIZE];
+} oat_output_buffer;
+
+static _Thread_local oat_output_buffer oat_output = { 0, -1, {0} };
+static atomic_flag oat_output_registered = ATOMIC_FLAG_INIT;
+
+static void oat_write_all(const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t n = write(STDOUT_FILENO, data, size);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    data += n;
+    size -= (size_t)n;
+  }
+}
+
+void oat_flush(void) {
+  oat_write_all(oat_output.data, oat_output.used);
+  oat_output.used = 0;
+}
+
+static void oat_print_bytes(const char* data, size_t size) {
+  oat_output_buffer* out = &oat_output;
+  if (out->line_buffered < 0) {
+    out->line_buffered = isatty(STDOUT_FILENO);
+    if (!atomic_flag_test_and_set(&oat_output_registered)) atexit(oat_flush);
+  }
+  if (size > OAT_OUTPUT_SIZE - out->used) {
+    oat_flush();
+    if (size > OAT_OUTPUT_SIZE) {
+      oat_write_all(data, size);
+      return;
+    }
+  }
+  memcpy(out->data + out->used, data, size);
+  out->used += size;
+  if (out->line_buffered && memchr(data, '\n', size) != NULL) oat_flush();
+}
+
+/*
+ * Write the decimal digits of i backwards, ending right before end
+ * @return the first character
+ */
+static char* oat_format_int(char* end, int32_t i) {
+  uint32_t u = i < 0 ? 0u - (uint32_t)i : (uint32_t)i;
+  char* p = end;
+  do {
+    *--p = (char)('0' + u % 10);
+    u /= 10;
+  } while (u != 0);
+  if (i < 0) *--p = '-';
+  return p;
+}
 
 /* Oat Internal Functions --------------------------------------------------- */
 
+/* Allocation of `new` arrays, kind is OAT_KIND_BYTES or OAT_KIND_POINTERS */
+void* oat_alloc(int32_t size, int32_t kind) {
+  assert (size >= 0);
+  return oat_alloc_bytes((size_t)size, kind);
+}
+
 int32_t* oat_malloc(int32_t size) {
-  return (int32_t*)calloc(size, sizeof(char));
+  return (int32_t*)oat_alloc_bytes((size_t)size, OAT_KIND_BYTES);
 }
 
 int32_t* oat_alloc_array (int32_t size) {
   assert (size >= 0);
-  int32_t *arr = (int32_t*)malloc(sizeof(int32_t) * (size+1));
+  int32_t *arr = (int32_t*)oat_alloc_bytes(sizeof(int32_t) * (size+1), OAT_KIND_BYTES);
   arr[0] = size;
   return arr;
 }	
 
-/* Oat Builtin Functions ---------------------------------------------------- */
-
-int32_t* array_of_string (char *str) {
-  int32_t len, i, *arr;
-
-  assert (NULL != str);
+/* A string of len characters, NUL-terminated, with its length in the header */
+static char* oat_alloc_string(size_t len) {
+  char* str = (char*)oat_alloc_bytes(sizeof(char) * (len + 1), OAT_KIND_BYTES);
+  OAT_HEADER(str)->length = (int32_t)len;
+  return str;
+}
 
-  len = strlen(str);
-  assert (len >= 0);
+static char* oat_concat(const char* l, size_t ll, const char* r, size_t lr) {
+  char* new = oat_alloc_string(ll + lr);
+  memcpy(new, l, ll);
+  memcpy(new + ll, r, lr);
+  return new;
+}
 
-  arr = (int32_t*)malloc(sizeof(int32_t) * (len+1));
+static int32_t* oat_array_of_chars(const char* str, int32_t len) {
+  int32_t i, *arr;
+  arr = (int32_t*)oat_alloc_bytes(sizeof(int32_t) * (len+1), OAT_KIND_BYTES);
   arr[0] = len;
   for (i=0; i<len; i++) {
     arr[i+1]=(int32_t)str[i];
   }
+  return arr;
+}
+
+/*
+ * The compiler calls the oat_* builtins, which read the cached lengths (length_of_string is a load
+ * of the header it emits inline). The C-string builtins below use strlen, for the IR of a4.py, whose strings
+ * have no header.
+ */
+
+int32_t oat_string_length (char *str) {
+  assert (NULL != str);
+  return OAT_HEADER(str)->length;
+}
+
+void oat_print_string (char* str) {
+  assert (NULL != str);
+  oat_print_bytes(str, OAT_HEADER(str)->length);
+}
 
-  return arr; 
+char* oat_string_cat(char* l, char* r) {
+  return oat_concat(l, OAT_HEADER(l)->length, r, OAT_HEADER(r)->length);
+}
+
+int32_t* oat_array_of_string (char *str) {
+  assert (NULL != str);
+  return oat_array_of_chars(str, OAT_HEADER(str)->length);
+}
+
+/* Oat Builtin Functions ---------------------------------------------------- */
+
+int32_t* array_of_string (char *str) {
+  assert (NULL != str);
+  return oat_array_of_chars(str, (int32_t)strlen(str));
 }
 
 char* string_of_array (int32_t *arr) {
@@ -55,13 +381,12 @@ char* string_of_array (int32_t *arr) {
   len = arr[0];
   assert (len >= 0);
 
-  str = malloc(sizeof(char) * (len+1));
-  
+  str = oat_alloc_string(len);
   for (i=0; i<len; i++) {
     str[i] = (char)arr[i+1];
-    assert (0 != str[i]);
   }
-  str[len] = 0;
+  /* one scan instead of a check per character */
+  assert (NULL == memchr(str, 0, len));
 
   return str;
 }
@@ -72,39 +397,34 @@ int32_t length_of_string (char *str) {
 }
 
 char* string_of_int(int32_t i) {
-  static char buf[128];
-  static int len;
-  len = sprintf(buf,"%ld",(long)i);
-  char* str = (char*) malloc(sizeof(char) * (len + 1));
-  memcpy(str, buf, len);
-  str[len] = 0;
-  return (char*)str;
+  char buf[OAT_INT_DIGITS];
+  char* digits = oat_format_int(buf + sizeof(buf), i);
+  size_t len = buf + sizeof(buf) - digits;
+  char* str = oat_alloc_string(len);
+  memcpy(str, digits, len);
+  return str;
 }
 
 char* string_cat(char* l, char* r) {
-  size_t ll = strlen(l);
-  size_t lr = strlen(r);
-  char* new = (char*) malloc(sizeof(char) * (ll + lr + 1));
-  memcpy(new, l, ll);
-  memcpy(new + ll, r, lr);
-  new[ll + lr] = 0;
-  return new;
+  return oat_concat(l, strlen(l), r, strlen(r));
 }
 
 void print_string (char* str) {
   assert (NULL != str);
-  printf ("%s", str);
+  oat_print_bytes(str, strlen(str));
 }
 
 void print_int (int32_t i) {
-  printf ("%ld", (long)i);
+  char buf[OAT_INT_DIGITS];
+  char* digits = oat_format_int(buf + sizeof(buf), i);
+  oat_print_bytes(digits, buf + sizeof(buf) - digits);
 }
 
 void print_bool (int32_t i) {
   if (i == 0) {
-    printf ("false");
+    oat_print_bytes("false", 5);
   } else {
-    printf ("true");
+    oat_print_bytes("true", 4);
   }
 }
 
@@ -0,0 +1,247 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 21st, 2026
+ *
+ * This file implements the Semantic Analyzer class defined in semantic_analyzer.hpp
+ */
+
+#include "semantic_analyzer.hpp"
+
+/**
+ * Data type of an array whose elements are of the given type
+ */
+static DataType array_of(DataType element) {
+    switch (element) {
+        case DataType::INT:     return DataType::INT_ARRAY;
+        case DataType::BOOL:    return DataType::BOOL_ARRAY;
+        case DataType::STRING:  return DataType::STRING_ARRAY;
+        default:                return DataType::NONE;
+    }
+}
+
+/**
+ * Data type of the elements of an array
+ */
+static DataType element_of(DataType array) {
+    switch (array) {
+        case DataType::INT_ARRAY:       return DataType::INT;
+        case DataType::BOOL_ARRAY:      return DataType::BOOL;
+        case DataType::STRING_ARRAY:    return DataType::STRING;
+        default:                        return DataType::NONE;
+    }
+}
+
+/**
+ * Data type of a child, NONE for a missing one
+ */
+static DataType datatype_of(Node* node) {
+    return node == nullptr ? DataType::NONE : node->datatype;
+}
+
+bool Semantic_Analyzer::analyze(Node* node) {
+    if (node == nullptr) {
+        std::cerr << "Error: the ast is empty!" << std::endl;
+        return false;
+    }
+    success = true;
+    analyze_node(node);
+    return success;
+}
+
+void Semantic_Analyzer::declare(Node* id_node, DataType datatype) {
+    auto &binding = symbol_table.insert(symbol_table.intern(id_node->lexeme), datatype);
+    id_node->scope_id = binding.scope_id;
+    id_node->datatype = datatype;
+}
+
+DataType Semantic_Analyzer::analyze_node(Node* root) {
+    if (root == nullptr) return DataType::NONE;
+    // Explicit stack of the nodes whose children are being analyzed, in place of recursion,
+    // so the depth of the AST is only bounded by memory
+    struct Frame {
+        Node* node;
+        size_t next_child;
+        size_t end_child;
+    };
+    std::vector<Frame> stack;
+    auto visit = [&](Node* node) {
+        if (node == nullptr) return;
+        Frame frame = {node, 0, node->children.size()};
+        enter_node(node, frame.next_child, frame.end_child);
+        stack.push_back(frame);
+    };
+    visit(root);
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        if (frame.next_child < frame.end_child) {
+            Node* node = frame.node;
+            size_t i = frame.next_child++;
+            if (node->symbol_class == SymbolClass::function_decl && i == 1) {
+                // the function is visible in its own body, the arguments and the body share one scope
+                symbol_table.insert(symbol_table.intern(node->children[1]->lexeme), datatype_of(node->children[0]));
+                symbol_table.push_scope();
+            }
+            visit(node->children[i]);
+            continue;
+        }
+        Node* node = frame.node;
+        stack.pop_back();
+        leave_node(node);
+    }
+    return root->datatype;
+}
+
+void Semantic_Analyzer::enter_node(Node* node, size_t &first, size_t &end) {
+    switch (node->symbol_class) {
+        case SymbolClass::program: {
+            symbol_table.push_scope();
+            // built-in functions of runtime.c live in the global scope
+            static const std::pair<const char*, DataType> builtins[] = {
+                {"array_of_string", DataType::INT_ARRAY},
+                {"string_of_array", DataType::STRING},
+                {"length_of_string", DataType::INT},
+                {"string_of_int", DataType::STRING},
+                {"string_cat", DataType::STRING},
+                {"print_string", DataType::VOID},
+                {"print_int", DataType::VOID},
+                {"print_bool", DataType::BOOL},
+            };
+            for (auto &builtin : builtins) {
+                symbol_table.insert(symbol_table.intern(builtin.first), builtin.second);
+            }
+            break;
+        }
+        case SymbolClass::ID: {
+            end = 0;
+            auto binding = symbol_table.lookup_global(symbol_table.intern(node->lexeme));
+            if (binding == nullptr) {
+                std::cerr << "Error: variable not defined: " << node->lexeme << std::endl;
+                success = false;
+                // unresolved, also for a node kept from an earlier analysis by compiler --watch
+                node->scope_id = 0;
+                node->datatype = DataType::NONE;
+                break;
+            }
+            node->scope_id = binding->scope_id;
+            node->datatype = binding->datatype;
+            break;
+        }
+        case SymbolClass::TINT:
+        case SymbolClass::INTLITERAL:
+            end = 0;
+            node->datatype = DataType::INT;
+            break;
+        case SymbolClass::TBOOL:
+        case SymbolClass::TRUE:
+        case SymbolClass::FALSE:
+            end = 0;
+            node->datatype = DataType::BOOL;
+            break;
+        case SymbolClass::TSTRING:
+        case SymbolClass::STRINGLITERAL:
+            end = 0;
+            node->datatype = DataType::STRING;
+            break;
+        case SymbolClass::TVOID:
+            end = 0;
+            node->datatype = DataType::VOID;
+            break;
+        case SymbolClass::ref:
+        case SymbolClass::NUL:
+        case SymbolClass::arg:
+        case SymbolClass::RETURN:
+            // only the (element, argument, returned) type or value
+            end = std::min<size_t>(end, 1);
+            break;
+        case SymbolClass::global_decl:
+        case SymbolClass::var_decl:
+            // the initializer is analyzed first, so `var x = x;` refers to the outer x
+            first = 1;
+            end = 2;
+            break;
+        case SymbolClass::args:
+            node->datatype = DataType::VOID;
+            break;
+        case SymbolClass::stmts:
+            node->datatype = DataType::INT;
+            break;
+        case SymbolClass::IF:
+        case SymbolClass::ELSE:
+        case SymbolClass::FOR:
+        case SymbolClass::WHILE:
+            symbol_table.push_scope();
+            break;
+        default:
+            break;
+    }
+}
+
+void Semantic_Analyzer::leave_node(Node* node) {
+    switch (node->symbol_class) {
+        case SymbolClass::program:
+        case SymbolClass::function_decl:
+        case SymbolClass::IF:
+        case SymbolClass::ELSE:
+        case SymbolClass::FOR:
+        case SymbolClass::WHILE:
+            symbol_table.pop_scope();
+            break;
+        case SymbolClass::ref:
+            node->datatype = array_of(datatype_of(node->children[0]));
+            break;
+        case SymbolClass::global_decl:
+        case SymbolClass::var_decl:
+            declare(node->children[0], datatype_of(node->children[1]));
+            node->datatype = node->children[0]->datatype;
+            break;
+        case SymbolClass::arg:
+            declare(node->children[1], datatype_of(node->children[0]));
+            node->datatype = node->children[1]->datatype;
+            break;
+        case SymbolClass::RETURN:
+            node->datatype = node->children.empty() ? DataType::VOID : datatype_of(node->children[0]);
+            break;
+        case SymbolClass::func_call:
+            node->datatype = node->children[0]->datatype;
+            break;
+        case SymbolClass::array_index:
+            node->datatype = element_of(node->children[0]->datatype);
+            break;
+        case SymbolClass::NEW:
+        case SymbolClass::new_init_value:
+        case SymbolClass::new_init_size:
+            node->datatype = array_of(node->children[0]->datatype);
+            break;
+        case SymbolClass::NUL:
+            node->datatype = datatype_of(node->children[0]);
+            break;
+        case SymbolClass::STAR:
+        case SymbolClass::PLUS:
+        case SymbolClass::MINUS:
+        case SymbolClass::LSHIFT:
+        case SymbolClass::RLSHIFT:
+        case SymbolClass::RASHIFT:
+        case SymbolClass::BAND:
+        case SymbolClass::BOR:
+        case SymbolClass::TILDE:
+            node->datatype = DataType::INT;
+            break;
+        case SymbolClass::LESS:
+        case SymbolClass::LESSEQ:
+        case SymbolClass::GREAT:
+        case SymbolClass::GREATEQ:
+        case SymbolClass::EQ:
+        case SymbolClass::NEQ:
+        case SymbolClass::LAND:
+        case SymbolClass::LOR:
+        case SymbolClass::NOT:
+            node->datatype = DataType::BOOL;
+            break;
+        default:
+            break;
+    }
+}
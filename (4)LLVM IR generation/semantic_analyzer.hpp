@@ -0,0 +1,66 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 21st, 2026
+ *
+ * This file defines the Semantic Analyzer class, which resolves identifiers to their scopes
+ * and fills in the data types of the AST, in the same way as semantic_analysis in a4.py.
+ */
+
+#ifndef CSC4180_SEMANTIC_ANALYZER_HPP
+#define CSC4180_SEMANTIC_ANALYZER_HPP
+
+#include "node.hpp"
+#include "symbol_table.hpp"
+
+/**
+ * Semantic Analyzer of Oat
+ *
+ * Scopes are numbered in the order they are opened, starting from 1 for the global scope,
+ * so the unique names (lexeme-scope_id) are the ones a4.py computes.
+ */
+class Semantic_Analyzer {
+public:
+    Semantic_Analyzer() = default;
+
+    /**
+     * Perform semantic analysis on the AST
+     * Every ID gets the scope it resolves to and its data type, declarations and expressions get their data types.
+     * @param node: root of the AST
+     * @return false if an identifier is used without being declared, the error is reported to std::cerr
+     */
+    bool analyze(Node* node);
+
+private:
+    /**
+     * Analyze one node and its subtree
+     * The tree is walked with an explicit stack: enter_node runs before the children, leave_node after them
+     * @return the data type of the node
+     */
+    DataType analyze_node(Node* node);
+
+    /**
+     * Open the scope of a node, or resolve a leaf, before its children are analyzed
+     * @param first, end: set to the range of children to analyze, all of them by default
+     */
+    void enter_node(Node* node, size_t &first, size_t &end);
+
+    /**
+     * Close the scope of a node, declare its identifier, or compute its data type from its children
+     */
+    void leave_node(Node* node);
+
+    /**
+     * Declare an identifier in the innermost scope and resolve the ID node to it
+     */
+    void declare(Node* id_node, DataType datatype);
+
+private:
+    SymbolTable symbol_table;
+    bool success = true;
+};
+
+#endif  // CSC4180_SEMANTIC_ANALYZER_HPP
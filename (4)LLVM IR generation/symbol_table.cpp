@@ -0,0 +1,61 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 21st, 2026
+ *
+ * This file implements the SymbolTable class defined in symbol_table.hpp
+ */
+
+#include "symbol_table.hpp"
+
+uint32_t SymbolTable::intern(const std::string &lexeme) {
+    auto it = ident_ids.find(lexeme);
+    if (it != ident_ids.end()) return it->second;
+    uint32_t ident = names.size();
+    ident_ids.emplace(lexeme, ident);
+    names.push_back(lexeme);
+    innermost.push_back(-1);
+    return ident;
+}
+
+uint32_t SymbolTable::push_scope() {
+    scope_ids.push_back(++id_counter);
+    scope_starts.push_back(bindings.size());
+    return id_counter;
+}
+
+void SymbolTable::pop_scope() {
+    size_t start = scope_starts.back();
+    while (bindings.size() > start) {
+        const Binding &binding = bindings.back();
+        innermost[binding.ident] = binding.shadowed;
+        bindings.pop_back();
+    }
+    scope_ids.pop_back();
+    scope_starts.pop_back();
+}
+
+const SymbolTable::Binding &SymbolTable::insert(uint32_t ident, DataType datatype) {
+    int32_t top = innermost[ident];
+    if (top >= 0 && (size_t)top >= scope_starts.back()) {
+        bindings[top].datatype = datatype;
+        return bindings[top];
+    }
+    bindings.push_back(Binding{ident, scope_ids.back(), datatype, top});
+    innermost[ident] = bindings.size() - 1;
+    return bindings.back();
+}
+
+const SymbolTable::Binding *SymbolTable::lookup_local(uint32_t ident) const {
+    int32_t top = innermost[ident];
+    if (top < 0 || (size_t)top < scope_starts.back()) return nullptr;
+    return &bindings[top];
+}
+
+const SymbolTable::Binding *SymbolTable::lookup_global(uint32_t ident) const {
+    int32_t top = innermost[ident];
+    return top < 0 ? nullptr : &bindings[top];
+}
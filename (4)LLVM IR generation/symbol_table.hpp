@@ -0,0 +1,86 @@
+/**
+ * --------------------------------------
+ * CUHK-SZ CSC4180: Compiler Construction
+ * Assignment 4: Oat v.1 Compiler Frontend
+ * --------------------------------------
+ * Author: HaoLUO
+ * Date: October 21st, 2026
+ *
+ * This file defines the SymbolTable class used by semantic analysis.
+ */
+
+#ifndef CSC4180_SYMBOL_TABLE_HPP
+#define CSC4180_SYMBOL_TABLE_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "node.hpp"
+
+/**
+ * Scoped symbol table of Oat
+ *
+ * Identifiers are interned into dense ids once. Instead of a stack of maps searched from the innermost scope,
+ * every identifier keeps a shadow stack of its bindings with the innermost one on top, so a lookup is a single
+ * array access whatever the nesting depth. The shadow stacks are threaded through one flat array of bindings
+ * in declaration order, and leaving a scope pops the bindings it introduced from that array.
+ */
+class SymbolTable {
+public:
+    struct Binding {
+        uint32_t ident;         // interned identifier
+        uint32_t scope_id;      // scope the binding belongs to
+        DataType datatype;
+        int32_t shadowed;       // index of the binding of the same identifier it hides, -1 if none
+    };
+
+    /**
+     * @param lexeme
+     * @return the dense id of the identifier, the same lexeme always gets the same id
+     */
+    uint32_t intern(const std::string &lexeme);
+
+    const std::string &name(uint32_t ident) const { return names[ident]; }
+
+    /**
+     * Push a new scope
+     * @return the ID of the newly pushed scope, IDs are never reused
+     */
+    uint32_t push_scope();
+
+    /**
+     * Pop the innermost scope and every binding declared in it
+     */
+    void pop_scope();
+
+    /**
+     * Bind an identifier in the innermost scope, a second insert in the same scope replaces the type
+     * @return the binding
+     */
+    const Binding &insert(uint32_t ident, DataType datatype);
+
+    /**
+     * Lookup an identifier in the innermost scope only
+     * @return the binding, nullptr if not found
+     */
+    const Binding *lookup_local(uint32_t ident) const;
+
+    /**
+     * Lookup an identifier in all the open scopes, innermost first
+     * @return the binding, nullptr if not found
+     */
+    const Binding *lookup_global(uint32_t ident) const;
+
+private:
+    std::unordered_map<std::string, uint32_t> ident_ids;
+    std::vector<std::string> names;         // ident -> lexeme
+    std::vector<int32_t> innermost;         // ident -> index of its innermost binding, -1 if unbound
+    std::vector<Binding> bindings;          // bindings of all open scopes, outermost first
+    std::vector<uint32_t> scope_ids;        // IDs of the open scopes
+    std::vector<size_t> scope_starts;       // size of bindings when each open scope was pushed
+    uint32_t id_counter = 0;
+};
+
+#endif  // CSC4180_SYMBOL_TABLE_HPP
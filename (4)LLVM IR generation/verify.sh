@@ -1,6 +1,6 @@
 #!bin/bash
 
-# compile runtime.c into LLVM IR
+# compile runtime.c into LLVM IR, add -DOAT_GC (and --gc to the compiler below) for the copying collector
 clang --target=riscv64 -emit-llvm -S -I/usr/include runtime.c -o runtime.ll
 
 mkdir -p ./testcases && cd testcases
@@ -11,11 +11,11 @@ mkdir -p ./riscv_assembly
 mkdir -p ./executable
 mkdir -p ./output
 
-for test_idx in {0..5}; do
+for test_idx in {0..8}; do
     test="test$test_idx"
     test_program="./test$test_idx.oat"
     tokens="./tokens/${test}.txt"
-    parser_ast_dot="./ast/${test}.dot"
+    parser_ast="./ast/${test}.ast"
     ast_png_after_semantic_analysis="./ast/${test}-after.png"
     self_ir="./llvm_ir/${test}-self.ll"
     merged_ir="./llvm_ir/${test}.ll"
@@ -23,8 +23,8 @@ for test_idx in {0..5}; do
     exe="./executable/${test}"
     output="./output/${test}.txt"
     echo "$test"
-    # Visualize initial output AST and the one after semantic analysis
-    python3 ../a4.py ${parser_ast_dot} ${ast_png_after_semantic_analysis} ${self_ir}
+    # Generate LLVM IR natively, `python3 ../a4.py ${parser_ast} ${ast_png_after_semantic_analysis} ${self_ir}` still works
+    ../compiler ${test_program} ${self_ir} > ${tokens}
     # Uncomment the following after you finish output the LLVM IR
     # Combine LLVM IR of source program and runtime functions into one merged IR file
     llvm-link ${self_ir} ../runtime.ll -o ${merged_ir}